@@ -5,45 +5,167 @@
 //  Created by Mert Arıcan on 2.12.2023.
 //
 
+#define _GNU_SOURCE // 'MAP_ANONYMOUS', 'MAP_HUGETLB', 'madvise' and 'syscall' aren't part of strict C11.
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <math.h>
+#include <errno.h>
+#include <assert.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(MAP_HUGETLB) && !defined(MAP_HUGE_2MB) // Only defined by <linux/mman.h>.
+#define MAP_HUGE_2MB (21 << 26) // log2('HUGE_PAGE_SIZE') << 'MAP_HUGE_SHIFT'
+#endif
+#endif
 
 #define BUFFER 256
 #define INSERT_VAL 'i'
 #define SEARCH_VAL 's'
 #define DELETE_VAL 'd'
 #define RELOCATE_VAL 'r'
+#define LIST_VAL 'l'
+#define MULTI_INSERT_VAL 'm'
+#define MULTI_SEARCH_VAL 'f'
+#define BATCH_CAPACITY 64
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define MAX_TABLE_LENGTH 1073741789 // Largest prime below 2^30, so that 'slot + step' of a probe fits in 'int'.
 
 // MARK: - Data structures, Initializers, Destructors
 
+/*
+ * constant: INLINE_NAME_CAPACITY
+ * ------------------------------
+ * Number of bytes (including the terminating '\0') that a 'Record' can store
+ * inside the slot itself. Names shorter than this are stored inline, so that
+ * comparing them doesn't require following a pointer to the heap.
+ */
+#define INLINE_NAME_CAPACITY 24
+
+/*
+ * constant: MAX_NAME_LENGTH
+ * -------------------------
+ * Maximum number of characters in a name, i.e., the biggest value that fits in 'length' of 'Record'.
+ */
+#define MAX_NAME_LENGTH ((1 << 30) - 1)
+
+/*
+ * constant: SLOT_ALIGNMENT
+ * ------------------------
+ * Alignment of slot arrays in bytes, i.e., size of a cache line.
+ */
+#define SLOT_ALIGNMENT 64
+
 /*
  * struct: record
  * -------------
  * struct used to represent records
+ *
+ * - Members:
+ *      - storage: either the name itself (if 'length' < 'INLINE_NAME_CAPACITY'),
+ *                 or a pointer to heap allocated copy of it.
+ *      - length: number of characters in name (excluding the terminating '\0'). Names may
+ *                contain '\0' characters, so this is the only reliable way to know it.
+ *      - occupied: whether this slot holds a record (whether active or passive).
+ *      - deleted: whether the record is softly deleted.
+ *      - prehashValue: result of 'prehash' function for the name, for the length of the table
+ *                      that holds this record. Compared before the name itself during searches.
+ *
+ * Flags share a word with 'length' (so names can be at most 'MAX_NAME_LENGTH' characters long), which
+ * keeps a record at 32 bytes. Slot arrays are aligned to 'SLOT_ALIGNMENT', so no record
+ * straddles two cache lines.
  */
 typedef struct record {
-    char *name;
-    bool deleted;
+    union {
+        char inlineName[INLINE_NAME_CAPACITY];
+        char *heapName;
+    } storage;
+    unsigned int length : 30;
+    unsigned int occupied : 1;
+    unsigned int deleted : 1;
+    int prehashValue;
 } Record;
 
+_Static_assert(sizeof(Record) == 32, "Record must stay 32 bytes, two records per cache line.");
+
+/*
+ * function: isNameStoredInline
+ * ----------------------------
+ * Returns whether the name of given 'record' is stored inside the record itself.
+ */
+bool isNameStoredInline(const Record *record) {
+    return record->length < INLINE_NAME_CAPACITY;
+}
+
+/*
+ * function: isValidNameLength
+ * ---------------------------
+ * Returns whether a name with given number of characters can be stored in a 'Record'.
+ */
+bool isValidNameLength(const int length) {
+    return length >= 0 && length <= MAX_NAME_LENGTH;
+}
+
+/*
+ * function: areValidNameLengths
+ * -----------------------------
+ * Returns whether all the names with given numbers of characters can be stored in a 'Record'.
+ */
+bool areValidNameLengths(const int lengths[], const int count) {
+    int i = 0;
+    for (i = 0; i < count; i++) {
+        if (!isValidNameLength(lengths[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * function: recordName
+ * --------------------
+ * Returns the name stored in given 'record', wherever it is stored.
+ */
+const char *recordName(const Record *record) {
+    return isNameStoredInline(record) ? record->storage.inlineName : record->storage.heapName;
+}
+
 /*
  * function: initRecordWithName
  * -------------------------
  * Function used to initialize and return 'Record'
  * value to the caller, for given 'name'.
  *
+ * Short names are copied into the record itself, only long ones get allocated on heap.
+ * Stored names are always '\0' terminated, even though 'name' doesn't need to be.
+ *
  * - Arguments:
- *      - name: String value that the 'record' is going to store.
+ *      - name: Characters that the 'record' is going to store.
+ *      - length: Number of characters in 'name', must be valid (see 'isValidNameLength').
+ *      - prehashValue: 'prehash' value of 'name' for the table that is going to hold the record.
  *
  * - Returns: 'Record' that stores the given 'name'.
  */
-Record initRecordWithName(const char *name) {
+Record initRecordWithName(const char *name, const int length, const int prehashValue) {
     Record record;
-    record.name = malloc(sizeof(char) * ((strlen(name)+1)));
-    strcpy(record.name, name);
+    char *storedName = NULL;
+    assert(isValidNameLength(length)); // Otherwise 'length' field would truncate it.
+    record.length = length;
+    if (length < INLINE_NAME_CAPACITY) { // Same as 'isNameStoredInline', without relying on the stored 'length'.
+        storedName = record.storage.inlineName;
+    }
+    else {
+        storedName = record.storage.heapName = malloc(sizeof(char) * (length+1));
+    }
+    memcpy(storedName, name, length);
+    storedName[length] = '\0';
+    record.prehashValue = prehashValue;
+    record.occupied = true;
     record.deleted = false;
     return record;
 }
@@ -57,9 +179,206 @@ Record initRecordWithName(const char *name) {
  *      - record: Pointer to a record
  */
 void freeRecord(Record *record) {
-    free(record->name);
+    if (record->occupied && !isNameStoredInline(record)) {
+        free(record->storage.heapName);
+    }
+    record->occupied = false;
+}
+
+/*
+ * enum: PageKind
+ * --------------
+ * enum used to represent the kind of pages that back the slot array of a hash table.
+ *
+ * case 'REGULAR_PAGES': Slot array is allocated with 'aligned_alloc'.
+ * case 'TRANSPARENT_HUGE_PAGES': Slot array is mapped with 'mmap' and kernel is advised to back it with huge pages.
+ * case 'EXPLICIT_HUGE_PAGES': Slot array is mapped from the reserved huge page pool ('MAP_HUGETLB').
+ *                             Falls back to 'TRANSPARENT_HUGE_PAGES' if the pool is empty.
+ */
+typedef enum {
+    REGULAR_PAGES,
+    TRANSPARENT_HUGE_PAGES,
+    EXPLICIT_HUGE_PAGES
+} PageKind;
+
+/*
+ * enum: NumaPlacement
+ * -------------------
+ * enum used to represent on which NUMA node(s) the slot array of a hash table should live.
+ *
+ * case 'NUMA_DEFAULT': Pages land on the node that touches them first.
+ * case 'NUMA_INTERLEAVE': Pages are spread over all nodes in round-robin fashion.
+ * case 'NUMA_BIND': Pages are placed on a single node.
+ */
+typedef enum {
+    NUMA_DEFAULT,
+    NUMA_INTERLEAVE,
+    NUMA_BIND
+} NumaPlacement;
+
+/*
+ * struct: AllocationPolicy
+ * ------------------------
+ * struct used to represent how the slot array of a hash table is allocated.
+ *
+ * Policy is only a request, every part of it that isn't available on the running system
+ * silently falls back to the default behaviour.
+ *
+ * - Members:
+ *      - pages: kind of pages to use.
+ *      - numa: NUMA placement of the pages.
+ *      - numaNode: node to bind pages to, if 'numa' is 'NUMA_BIND'.
+ *      - debugMode: whether a 'DEBUG' message should be printed when a part of the policy falls back.
+ */
+typedef struct allocation_policy {
+    PageKind pages;
+    NumaPlacement numa;
+    int numaNode;
+    bool debugMode;
+} AllocationPolicy;
+
+/*
+ * function: placePagesOnNumaNodes
+ * -------------------------------
+ * Function that applies the NUMA part of given 'policy' to given mapped memory. Must be
+ * called before the memory is touched, since pages are placed on first touch.
+ *
+ * 'mbind' is called through 'syscall', so that the program doesn't depend on 'libnuma'.
+ * Only the first 'NUMA_NODE_MASK_BITS' nodes can be used.
+ *
+ * - Arguments:
+ *      - memory: start of the mapped memory.
+ *      - size: size of the mapped memory in bytes.
+ *      - policy: allocation policy.
+ */
+#define NUMA_NODE_MASK_BITS ((int) (sizeof(unsigned long) * 8))
+void placePagesOnNumaNodes(void *memory, const size_t size, const AllocationPolicy policy) {
+#if defined(__linux__) && defined(SYS_mbind)
+    const int MPOL_BIND_MODE = 2;
+    const int MPOL_INTERLEAVE_MODE = 3;
+    unsigned long nodeMask = 0;
+    int mode = 0;
+    if (policy.numa == NUMA_INTERLEAVE) {
+        nodeMask = ~0UL; // Kernel ignores the nodes that aren't allowed for this process.
+        mode = MPOL_INTERLEAVE_MODE;
+    }
+    else if (policy.numa == NUMA_BIND) {
+        if (policy.numaNode < 0 || policy.numaNode >= NUMA_NODE_MASK_BITS) {
+            if (policy.debugMode) {
+                printf("DEBUG: NUMA node %d is out of range (0-%d), using the default placement.\n", policy.numaNode, NUMA_NODE_MASK_BITS-1);
+            }
+            return;
+        }
+        nodeMask = 1UL << policy.numaNode;
+        mode = MPOL_BIND_MODE;
+    }
+    else {
+        return;
+    }
+    // Kernel reads 'maxnode - 1' bits of the mask, hence the '+ 1'.
+    if (syscall(SYS_mbind, memory, size, mode, &nodeMask, NUMA_NODE_MASK_BITS + 1, 0) != 0 && policy.debugMode) {
+        printf("DEBUG: Couldn't apply NUMA placement (%s), using the default placement.\n", strerror(errno));
+    }
+#else
+    (void) memory; (void) size;
+    if (policy.numa != NUMA_DEFAULT && policy.debugMode) {
+        printf("DEBUG: NUMA placement isn't supported on this system, using the default placement.\n");
+    }
+#endif
+}
+
+/*
+ * function: allocateSlots
+ * -----------------------
+ * Function that allocates zero filled memory for 'M' records, according to given 'policy'.
+ * Zero filled record is an empty slot, so returned memory doesn't need further initialization.
+ *
+ * Arrays smaller than a huge page are always allocated with 'aligned_alloc', since neither huge pages
+ * nor NUMA placement can make a difference for them.
+ *
+ * - Arguments:
+ *      - M: number of records.
+ *      - policy: allocation policy.
+ *      - mappedSize: set to the number of mapped bytes if the memory is mapped with 'mmap',
+ *                    or to '0' if it is allocated with 'aligned_alloc'.
+ *
+ * - Returns: Allocated records.
+ */
+Record *allocateSlots(const int M, const AllocationPolicy policy, size_t *mappedSize) {
+    const size_t size = sizeof(Record) * M;
+    *mappedSize = 0;
+#ifdef __linux__
+    if (size >= HUGE_PAGE_SIZE && (policy.pages != REGULAR_PAGES || policy.numa != NUMA_DEFAULT)) {
+        void *memory = MAP_FAILED;
+        const size_t hugeSize = ((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+        if (policy.pages == EXPLICIT_HUGE_PAGES) {
+            memory = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0); // Not the default huge page size, which may be 1 GB.
+            if (memory != MAP_FAILED) {
+                *mappedSize = hugeSize;
+            }
+            else if (policy.debugMode) {
+                printf("DEBUG: Couldn't map explicit huge pages (%s), using transparent huge pages.\n", strerror(errno));
+            }
+        }
+#endif
+        if (memory == MAP_FAILED) {
+            memory = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory != MAP_FAILED) {
+                *mappedSize = hugeSize;
+#ifdef MADV_HUGEPAGE
+                if (policy.pages != REGULAR_PAGES && madvise(memory, hugeSize, MADV_HUGEPAGE) != 0 && policy.debugMode) {
+                    printf("DEBUG: Couldn't enable transparent huge pages (%s).\n", strerror(errno));
+                }
+#endif
+            }
+            else if (policy.debugMode) {
+                printf("DEBUG: Couldn't map the table (%s), using regular allocation.\n", strerror(errno));
+            }
+        }
+        if (memory != MAP_FAILED) {
+            placePagesOnNumaNodes(memory, *mappedSize, policy);
+            return memory;
+        }
+    }
+#else
+    (void) policy;
+#endif
+    const size_t alignedSize = ((size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT) * SLOT_ALIGNMENT;
+    Record *records = aligned_alloc(SLOT_ALIGNMENT, alignedSize); // 'calloc' only guarantees 16 bytes.
+    if (records != NULL) {
+        memset(records, 0, alignedSize);
+    }
+    return records;
+}
+
+/*
+ * function: releaseSlots
+ * ----------------------
+ * Function that releases the memory allocated by 'allocateSlots'. Doesn't free the records themselves.
+ *
+ * - Arguments:
+ *      - records: records returned from 'allocateSlots'.
+ *      - mappedSize: 'mappedSize' value returned from 'allocateSlots'.
+ *      - debugMode: whether a failing 'munmap' should be reported or not.
+ */
+void releaseSlots(Record *records, const size_t mappedSize, const bool debugMode) {
+#ifdef __linux__
+    if (mappedSize > 0) {
+        if (munmap(records, mappedSize) != 0 && debugMode) {
+            printf("DEBUG: Couldn't unmap the table (%s).\n", strerror(errno));
+        }
+        return;
+    }
+#else
+    (void) mappedSize;
+    (void) debugMode;
+#endif
+    free(records);
 }
 
+struct table_snapshot; // See 'TableSnapshot'.
+
 /*
  * struct: HashTable
  * -----------------
@@ -67,9 +386,17 @@ void freeRecord(Record *record) {
  */
 typedef struct hash_table {
     Record *values;
+    size_t valuesMappedSize; // 'mappedSize' value returned from 'allocateSlots' for 'values'.
+    struct table_snapshot *snapshots; // Snapshots that read from 'values', see 'preserveSlotForSnapshots'.
+    int liveSnapshotCount; // Number of snapshots that aren't released yet, including the ones of relocated 'values'.
+    char **retiredNames; // Heap allocated names that the table doesn't use anymore, but snapshots may still do.
+    int retiredNameCount;
+    int retiredNameCapacity;
+    AllocationPolicy allocationPolicy;
     float loadFactor;
     int length;
     int activeRecordCount;
+    int usedSlotCount; // Number of slots that hold a record, whether active or softly deleted.
 } HashTable;
 
 /*
@@ -80,24 +407,212 @@ typedef struct hash_table {
  * - Arguments:
  *      - M: Length of the hash table.
  *      - loadFactor: Load factor determined by user.
+ *      - allocationPolicy: How the slots of the table should be allocated.
  *
  * - Returns: Allocated 'HashTable' instance.
  */
-HashTable *createTable(const int M, const float loadFactor) {
+HashTable *createTable(const int M, const float loadFactor, const AllocationPolicy allocationPolicy) {
     HashTable *table = malloc(sizeof(HashTable));
-    Record *records = malloc(sizeof(Record)*M);
-    table->values = records;
+    table->values = allocateSlots(M, allocationPolicy, &table->valuesMappedSize); // All slots are empty.
+    table->snapshots = NULL;
+    table->liveSnapshotCount = 0;
+    table->retiredNames = NULL;
+    table->retiredNameCount = 0;
+    table->retiredNameCapacity = 0;
+    table->allocationPolicy = allocationPolicy;
     table->loadFactor = loadFactor;
-    int i = 0;
-    for (i = 0; i < M; i++) {
-        records[i].name = NULL;
-        records[i].deleted = 0;
-    }
     table->activeRecordCount = 0;
+    table->usedSlotCount = 0;
     table->length = M;
     return table;
 }
 
+/*
+ * function: releaseRecords
+ * ------------------------
+ * Function that frees all the records in given slots, and then the slots themselves.
+ *
+ * - Arguments:
+ *      - records: records returned from 'allocateSlots'.
+ *      - M: number of records.
+ *      - mappedSize: 'mappedSize' value returned from 'allocateSlots'.
+ *      - debugMode: whether a failing 'munmap' should be reported or not.
+ */
+void releaseRecords(Record *records, const int M, const size_t mappedSize, const bool debugMode) {
+    int i = 0;
+    for (i = 0; i < M; i++) {
+        freeRecord(&records[i]);
+    }
+    releaseSlots(records, mappedSize, debugMode);
+}
+
+/*
+ * constant: SNAPSHOT_CHUNK_LENGTH
+ * -------------------------------
+ * Number of records that are preserved at once for a snapshot, before the table modifies one of them.
+ */
+#define SNAPSHOT_CHUNK_LENGTH 2048
+
+/*
+ * struct: FrozenSlots
+ * -------------------
+ * struct used to represent the records that a table has relocated away from, while snapshots were
+ * still reading them. Records are never modified again, and are released with the last snapshot.
+ */
+typedef struct frozen_slots {
+    Record *values;
+    size_t mappedSize;
+    int referenceCount;
+} FrozenSlots;
+
+/*
+ * struct: TableSnapshot
+ * ---------------------
+ * struct used to represent the records of a hash table at the time the snapshot is taken.
+ *
+ * Snapshot reads the records of the table itself. Before the table modifies a record, it preserves
+ * the chunk of 'SNAPSHOT_CHUNK_LENGTH' records around it for the snapshot (see 'preserveSlotForSnapshots'),
+ * so a write copies only the chunk it touches, once per snapshot. Chunks are shallow copies, heap
+ * allocated names are shared with the table (see 'retireRecordName'). When the table is relocated,
+ * snapshots keep the old records (see 'freezeValuesForSnapshots').
+ *
+ * - Members:
+ *      - table: table that the snapshot is taken from.
+ *      - values: records that the snapshot reads, unless the chunk is preserved.
+ *      - preservedChunks: copies of the chunks that are preserved before the table modified them ('NULL' if not).
+ *      - frozenValues: owner of 'values' once the table is relocated, 'NULL' before.
+ *      - length: number of slots in 'values'.
+ *      - activeRecordCount: number of active records at the time the snapshot is taken.
+ *      - next: next snapshot in the 'snapshots' list of the table.
+ */
+typedef struct table_snapshot {
+    HashTable *table;
+    const Record *values;
+    Record **preservedChunks;
+    FrozenSlots *frozenValues;
+    int length;
+    int activeRecordCount;
+    struct table_snapshot *next;
+} TableSnapshot;
+
+/*
+ * function: retireRecordName
+ * --------------------------
+ * Function that must be used instead of 'freeRecord' when the table drops a record. If a snapshot is
+ * alive, it may still read the name of the record, so freeing it is deferred until all the snapshots
+ * are released (see 'reclaimRetiredNames'). Doesn't modify the record itself.
+ *
+ * - Arguments:
+ *      - table: hash table that drops the record.
+ *      - record: dropped record.
+ */
+void retireRecordName(HashTable *table, const Record *record) {
+    if (!record->occupied || isNameStoredInline(record)) {
+        return;
+    }
+    if (table->liveSnapshotCount == 0) {
+        free(record->storage.heapName);
+        return;
+    }
+    if (table->retiredNameCount == table->retiredNameCapacity) {
+        table->retiredNameCapacity = (table->retiredNameCapacity == 0) ? 16 : table->retiredNameCapacity * 2;
+        table->retiredNames = realloc(table->retiredNames, sizeof(char *) * table->retiredNameCapacity);
+    }
+    table->retiredNames[table->retiredNameCount++] = record->storage.heapName;
+}
+
+/*
+ * function: reclaimRetiredNames
+ * -----------------------------
+ * Function that frees the names retired by 'retireRecordName', if no snapshot is alive anymore.
+ *
+ * - Arguments:
+ *      - table: hash table.
+ */
+void reclaimRetiredNames(HashTable *table) {
+    int i = 0;
+    if (table->liveSnapshotCount > 0) {
+        return;
+    }
+    for (i = 0; i < table->retiredNameCount; i++) {
+        free(table->retiredNames[i]);
+    }
+    free(table->retiredNames);
+    table->retiredNames = NULL;
+    table->retiredNameCount = 0;
+    table->retiredNameCapacity = 0;
+}
+
+/*
+ * function: preserveSlotForSnapshots
+ * ----------------------------------
+ * Function that must be called before modifying the record at given 'slot' of given 'table'.
+ * Every snapshot that reads the records of the table, and hasn't preserved the chunk of 'slot'
+ * yet, gets a copy of that chunk. Does nothing if there is no such snapshot.
+ *
+ * - Arguments:
+ *      - table: hash table that is going to be modified.
+ *      - slot: slot that is going to be modified.
+ */
+void preserveSlotForSnapshots(HashTable *table, const int slot) {
+    const int chunk = slot / SNAPSHOT_CHUNK_LENGTH;
+    const int chunkStart = chunk * SNAPSHOT_CHUNK_LENGTH;
+    const int chunkLength = (table->length - chunkStart < SNAPSHOT_CHUNK_LENGTH) ? (table->length - chunkStart) : SNAPSHOT_CHUNK_LENGTH;
+    TableSnapshot *snapshot = NULL;
+    for (snapshot = table->snapshots; snapshot != NULL; snapshot = snapshot->next) {
+        if (snapshot->preservedChunks[chunk] == NULL) {
+            snapshot->preservedChunks[chunk] = malloc(sizeof(Record) * chunkLength);
+            memcpy(snapshot->preservedChunks[chunk], &table->values[chunkStart], sizeof(Record) * chunkLength);
+        }
+    }
+}
+
+/*
+ * function: freezeValuesForSnapshots
+ * ----------------------------------
+ * Function that must be called before the table replaces its records during a relocation.
+ * Hands the records over to the snapshots that read them, which release them with the last one.
+ *
+ * - Arguments:
+ *      - table: hash table that is being relocated.
+ *
+ * - Returns: Whether the records are handed over. If not, the table should release them.
+ */
+bool freezeValuesForSnapshots(HashTable *table) {
+    TableSnapshot *snapshot = NULL;
+    FrozenSlots *frozen = NULL;
+    if (table->snapshots == NULL) {
+        return false;
+    }
+    frozen = malloc(sizeof(FrozenSlots));
+    frozen->values = table->values;
+    frozen->mappedSize = table->valuesMappedSize;
+    frozen->referenceCount = 0;
+    for (snapshot = table->snapshots; snapshot != NULL; snapshot = snapshot->next) {
+        snapshot->frozenValues = frozen;
+        frozen->referenceCount++;
+    }
+    table->snapshots = NULL;
+    return true;
+}
+
+/*
+ * function: freeTable
+ * -------------------
+ * Function used for freeing the memory used by given 'table'.
+ *
+ * > Warning:
+ *  All the snapshots of the table must be released before.
+ *
+ * - Arguments:
+ *      - table: hash table to free.
+ */
+void freeTable(HashTable *table) {
+    reclaimRetiredNames(table);
+    releaseRecords(table->values, table->length, table->valuesMappedSize, table->allocationPolicy.debugMode);
+    free(table);
+}
+
 /*
  * enum: QueryResultStatus
  * -----------------------
@@ -147,7 +662,10 @@ typedef enum {
     INSERT = INSERT_VAL,
     SEARCH = SEARCH_VAL,
     DELETE = DELETE_VAL,
-    RELOCATE = RELOCATE_VAL
+    RELOCATE = RELOCATE_VAL,
+    LIST = LIST_VAL,
+    MULTI_INSERT = MULTI_INSERT_VAL,
+    MULTI_SEARCH = MULTI_SEARCH_VAL
 } UserAction;
 
 
@@ -168,12 +686,32 @@ typedef enum {
 bool isPrime(const int number) {
     if (number < 2) { return false; }
     int i = 0;
-    for (i=2; i<=number/2; i++) {
+    for (i=2; i<=number/i; i++) { // A composite number has a divisor that is not bigger than its square root.
         if (number % i == 0) { return false; }
     }
     return true;
 }
 
+/*
+ * function: greatestCommonDivisor
+ * -------------------------------
+ *
+ * Returns the greatest common divisor of given positive numbers, using Euclid's algorithm.
+ *
+ * - Arguments
+ *      - a, b: Numbers.
+ *
+ * - Returns: The greatest common divisor of 'a' and 'b'.
+ */
+int greatestCommonDivisor(int a, int b) {
+    while (b != 0) {
+        const int remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
 /*
  * function: firstPrimeThatFollowsGivenNumber
  * ------------------------------------------
@@ -195,7 +733,7 @@ int firstPrimeThatFollowsGivenNumber(const int number) {
     }
     int n = (number / 6);
     while (true) {
-        if (((6*n)-1 >= number) && isPrime(6*n)-1) {
+        if (((6*n)-1 >= number) && isPrime((6*n)-1)) {
             return 6*n - 1;
         }
         if (((6*n)+1 >= number) && isPrime((6*n)+1)) {
@@ -236,7 +774,7 @@ int getPrimeToBuildTable(float *_loadFactor) {
         validLoadFactor = loadFactor > 0.0 && loadFactor < 1.0;
     }
     printf("\n"); *_loadFactor = loadFactor;
-    return firstPrimeThatFollowsGivenNumber(ceil(((double) N) / loadFactor));
+    return firstPrimeThatFollowsGivenNumber(fmin(ceil(((double) N) / loadFactor), MAX_TABLE_LENGTH));
 }
 
 // MARK: - Hash functions
@@ -249,29 +787,33 @@ int getPrimeToBuildTable(float *_loadFactor) {
  * using Horner's rule. This is the first step of hashing a string. This numeric value later
  * gets used by hash function(s) to produce a valid hash value.
  *
+ * Characters are treated as unsigned bytes, so that names with non-ASCII characters (or
+ * arbitrary binary names) can't produce a negative value.
+ *
  * - Arguments
- *      - name: string value to map to a number.
+ *      - name: characters to map to a number. Doesn't need to be '\0' terminated.
+ *      - length: number of characters in 'name'.
+ *      - M: length of the hash table that this function creates prehash value for.
  *
  * - Returns: A 'prehash' value of type 'int'. This value is going to get mapped to a valid
  *          key by hash function(s).
  */
-int prehash(const char *name, const int M) {
+int prehash(const char *name, const int length, const int M) {
     int i = 0;
-    const int PRIME = 31;
-    int prehashValue = 0;
-    for (i = ((int) strlen(name)-1); i >= 0; i--) {
-        prehashValue = (PRIME * prehashValue + name[i]) % M; // Take modulo at each step to prevent overflow.
-                                                            // This will not change the overall result.
+    const long long PRIME = 31;
+    long long prehashValue = 0; // 'PRIME * prehashValue' doesn't fit in 'int' for tables longer than 'INT_MAX / PRIME'.
+    for (i = length-1; i >= 0; i--) {
+        prehashValue = (PRIME * prehashValue + (unsigned char) name[i]) % M; // Take modulo at each step to prevent overflow.
+                                                                            // This will not change the overall result.
     }
-    return prehashValue;
+    return (int) prehashValue;
 }
 
 /*
  * function: hash1
  * ---------------
  *
- * Function that first maps a given set of characters (i.e. name) to a numeric value
- * using 'prehash' function, and then maps this number to valid index on hash table
+ * Function that maps the 'prehash' value of a name to valid index on hash table
  * by using division method.
  *
  * This function maps the all possible universe of keys (result of 'prehash' function)
@@ -279,24 +821,23 @@ int prehash(const char *name, const int M) {
  *
  * > Warning:
  *  Value of this function shouldn't be used directly to store a value, but rather should
- *  be used as a part of 'hash' function.
+ *  be used as a part of the probe sequence (see '__search').
  *
  * - Arguments:
- *      - name: string value to hash.
+ *      - prehashValue: result of 'prehash' function for the name to hash.
  *      - M: length of the hash table that this function creates hash value for.
  *
- * - Returns: Valid hash number to be used in hash function for given 'name'.
+ * - Returns: Valid hash number to be used in hash function for given name.
  */
-int hash1(const char *name, const int M) {
-    return prehash(name, M) % M;
+int hash1(const int prehashValue, const int M) {
+    return prehashValue % M;
 }
 
 /*
  * function: hash2
  * ---------------
  *
- * Function that first maps a given set of characters (i.e. name) to a numeric value
- * using 'prehash' function, and then maps this number to valid index on hash table
+ * Function that maps the 'prehash' value of a name to valid index on hash table
  * by using division method.
  *
  * This function maps the all possible universe of keys (result of 'prehash' function)
@@ -304,37 +845,19 @@ int hash1(const char *name, const int M) {
  *
  * > Warning:
  *  Value of this function shouldn't be used directly to store a value, but rather should
- *  be used as a part of 'hash' function.
- *
- * - Arguments:
- *      - name: string value to hash.
- *      - M: length of the hash table that this function creates hash value for.
- *
- * - Returns: Valid hash number to be used in hash function for given 'name'.
- */
-int hash2(const char *name, const int M) {
-    return 1 + (prehash(name, M) % (M-2));
-}
-
-/*
- * function: hash
- * --------------
- *
- * Function that creates hash value for given 'name' considering collisions with other values.
- * This function uses 'Double Hashing' strategy to resolve collisions.
- *
- * For this function to be a valid hash function: (k: arbitrary key, h: hash function, (k, x): pair of key and collision count)
- *  - For all h(k, 1), h(k, 2) all the way up to h(k, M-1), this should be a permutation of 0, 1, ..., M-1.
+ *  be used as a part of the probe sequence (see '__search').
  *
  * - Arguments:
- *      - name: string value to hash.
- *      - collisionCount: 'int' value that represents the collision count.
+ *      - prehashValue: result of 'prehash' function for the name to hash.
  *      - M: length of the hash table that this function creates hash value for.
  *
- * - Returns: Valid hash number for given 'name'.
+ * - Returns: Valid hash number to be used in hash function for given name.
  */
-int hash(const char *name, const int collisionCount, const int M) {
-    return (hash1(name, M) + (collisionCount * hash2(name, M))) % M;
+int hash2(const int prehashValue, const int M) {
+    if (M <= 2) { // 'M-2' would be '0'. Step of '1' visits every slot of such a small table.
+        return 1;
+    }
+    return 1 + (prehashValue % (M-2));
 }
 
 
@@ -356,7 +879,7 @@ int hash(const char *name, const int collisionCount, const int M) {
  *              given 'table' at given 'slot'.
  */
 bool isThereAnyRecordInSlot(Record *table, const int slot) {
-    return (table[slot].name != NULL);
+    return table[slot].occupied;
 }
 
 /*
@@ -374,7 +897,29 @@ bool isThereAnyRecordInSlot(Record *table, const int slot) {
  *              given 'table' at given 'slot'.
  */
 bool isThereAnyActiveRecordInSlot(Record *table, const int slot) {
-    return ((table[slot].name != NULL) && !(table[slot].deleted));
+    return (table[slot].occupied && !(table[slot].deleted));
+}
+
+/*
+ * function: recordHasName
+ * -----------------------
+ *
+ * Function that returns whether given 'record' stores given 'name'. Lengths and 'prehash'
+ * values are compared first, so that the characters are compared only if the names are
+ * very likely to be equal.
+ *
+ * - Arguments:
+ *      - record: record to compare.
+ *      - name: name to compare.
+ *      - length: number of characters in 'name'.
+ *      - prehashValue: 'prehash' value of 'name' for the table that holds 'record'.
+ *
+ * - Returns: Whether given 'record' stores given 'name'.
+ */
+bool recordHasName(const Record *record, const char *name, const int length, const int prehashValue) {
+    return (record->length == length &&
+            record->prehashValue == prehashValue &&
+            memcmp(recordName(record), name, length) == 0);
 }
 
 /*
@@ -385,6 +930,11 @@ bool isThereAnyActiveRecordInSlot(Record *table, const int slot) {
  * and 'delete' actions. Returns a value of type 'QueryResult'.
  * 'QueryResult' is a struct that is basically a pair of 'index' and 'status' pairs.
  *
+ * Collisions are resolved with 'Double Hashing': the i-th probe is at '(hash1 + i * hash2) % M',
+ * computed by adding 'hash2' to the previous slot (so there is no multiplication to overflow).
+ * 'M' is prime and '1 <= hash2 < M', so probes 0, 1, ..., M-1 are a permutation of all the slots,
+ * and the table is full once the probe is back at 'hash1'.
+ *
  * - This function returns either:
  *
  *      - if 'name' is in the given 'table', then it is the 'index' of that item
@@ -402,6 +952,8 @@ bool isThereAnyActiveRecordInSlot(Record *table, const int slot) {
  *
  * - Arguments:
  *      - name: Name to search for.
+ *      - length: Number of characters in 'name'.
+ *      - prehashValue: 'prehash' value of 'name' for 'M'.
  *      - table: Hash table.
  *      - M: Number of slots in table.
  *
@@ -413,46 +965,46 @@ bool isThereAnyActiveRecordInSlot(Record *table, const int slot) {
  *
  * - Returns: 'QueryResult' value as explained above.
  */
-QueryResult __search(const char *name, Record *table, const int M, UserAction action, bool debugMode) {
-    int collisionCount = 0;
-    const int initialHash = hash(name, collisionCount, M);
+QueryResult __search(const char *name, const int length, const int prehashValue, Record *table, const int M, UserAction action, bool debugMode) {
+    const int initialHash = hash1(prehashValue, M);
+    const int step = hash2(prehashValue, M);
     int slot = initialHash;
     if (debugMode) {
         if (!(action == RELOCATE)) {
             printf("\nDEBUG DESCRIPTION FOR %s\n\n", (action == INSERT) ? "INSERT" : (action == SEARCH) ? "SEARCH" : "DELETE");
         }
-        printf("h1(\"%s\") = %d\n", name, hash1(name, M));
-        printf("h2(\"%s\") = %d\n\n", name, hash2(name, M));
+        printf("h1(\"%.*s\") = %d\n", length, name, hash1(prehashValue, M));
+        printf("h2(\"%.*s\") = %d\n\n", length, name, hash2(prehashValue, M));
     }
     QueryResult result = { slot, RECORD_NOT_FOUND }; // Initialize result with default values.
     while (isThereAnyRecordInSlot(table, slot)) { // While there is a record in table at position 'slot'...
-        Record record = table[slot];
-        if (strcmp(name, record.name) == 0) { // If this record has the same as given 'name'...
+        const Record *record = &table[slot]; // Use a pointer, inline names make 'Record' too big to copy on each probe.
+        if (recordHasName(record, name, length, prehashValue)) { // If this record has the same as given 'name'...
             result.slot = slot; // Assign the found 'slot' value to 'result'.
-            result.status = (record.deleted) ? PASSIVE_RECORD_FOUND : ACTIVE_RECORD_FOUND; // If record is 'deleted' then status is 'passive' else 'active'.
+            result.status = (record->deleted) ? PASSIVE_RECORD_FOUND : ACTIVE_RECORD_FOUND; // If record is 'deleted' then status is 'passive' else 'active'.
             if (debugMode) {
                 if (action == INSERT) {
                     if (result.status == PASSIVE_RECORD_FOUND) {
-                        printf("DEBUG: Empty slot for inserting '%s' is found at %d.\n", name, result.slot);
+                        printf("DEBUG: Empty slot for inserting '%.*s' is found at %d.\n", length, name, result.slot);
                     }
                     else {
-                        printf("DEBUG: '%s' is already in table at position %d.\n", name, result.slot);
+                        printf("DEBUG: '%.*s' is already in table at position %d.\n", length, name, result.slot);
                     }
                 }
                 else if (action == SEARCH) {
                     if (result.status == PASSIVE_RECORD_FOUND) {
-                        printf("DEBUG: Couldn't find '%s' in the table.\n", name);
+                        printf("DEBUG: Couldn't find '%.*s' in the table.\n", length, name);
                     }
                     else {
-                        printf("DEBUG: '%s' is found at position %d.\n", name, result.slot);
+                        printf("DEBUG: '%.*s' is found at position %d.\n", length, name, result.slot);
                     }
                 }
                 else if (action == DELETE) {
                     if (result.status == PASSIVE_RECORD_FOUND) {
-                        printf("DEBUG: Couldn't find '%s' in the table to delete.\n", name);
+                        printf("DEBUG: Couldn't find '%.*s' in the table to delete.\n", length, name);
                     }
                     else {
-                        printf("DEBUG: '%s' is removed from position %d.\n", name, result.slot);
+                        printf("DEBUG: '%.*s' is removed from position %d.\n", length, name, result.slot);
                     }
                 }
             }
@@ -461,16 +1013,19 @@ QueryResult __search(const char *name, Record *table, const int M, UserAction ac
         else { // means that there is a collision...
             if (debugMode) {
                 if (action == INSERT) {
-                    printf("DEBUG: Couldn't find empty slot at index: %d to insert '%s'.\n", result.slot, name);
+                    printf("DEBUG: Couldn't find empty slot at index: %d to insert '%.*s'.\n", result.slot, length, name);
                 }
                 else if (action == SEARCH) {
-                    printf("DEBUG: Couldn't find '%s' at the adress %d.\n", name, result.slot);
+                    printf("DEBUG: Couldn't find '%.*s' at the adress %d.\n", length, name, result.slot);
                 }
                 else if (action == DELETE) {
-                    printf("DEBUG: Couldn't find '%s' at the adress %d (delete attempt failed).\n", name, result.slot);
+                    printf("DEBUG: Couldn't find '%.*s' at the adress %d (delete attempt failed).\n", length, name, result.slot);
                 }
             }
-            slot = hash(name, ++collisionCount, M); // Compute the new hash value with incremented 'collisionCount'
+            slot += step; // Next slot of the probe sequence.
+            if (slot >= M) {
+                slot -= M;
+            }
             result.slot = slot; // update 'slot' value of result
             if (slot == initialHash) {
                 // If new has value is same as the initial hash value created for slot, that means there is no empty slot in table.
@@ -484,79 +1039,358 @@ QueryResult __search(const char *name, Record *table, const int M, UserAction ac
     }
     if (debugMode) {
         if (action == INSERT) {
-            printf("DEBUG: Empty slot for inserting %s into table is found at index %d.\n", name, result.slot);
+            printf("DEBUG: Empty slot for inserting %.*s into table is found at index %d.\n", length, name, result.slot);
         }
         else if (action == SEARCH) {
-            printf("DEBUG: Couldn't find '%s' at the adress %d.\n", name, result.slot);
+            printf("DEBUG: Couldn't find '%.*s' at the adress %d.\n", length, name, result.slot);
         }
         else if (action == DELETE) {
-            printf("DEBUG: Couldn't find '%s' at the adress %d (delete attempt failed).\n", name, result.slot);
+            printf("DEBUG: Couldn't find '%.*s' at the adress %d (delete attempt failed).\n", length, name, result.slot);
         }
     }
     return result;
 }
 
 /*
- * function: createAndInsertNewRecordToTable
- * -----------------------------------------
+ * constant: PROBE_GROUP_SIZE
+ * --------------------------
+ * Number of queries that '__multiSearch' keeps in flight at the same time.
+ */
+#define PROBE_GROUP_SIZE 8
+
+/*
+ * struct: ProbeState
+ * ------------------
+ * struct used to represent a query that is being performed one probe at a time by '__multiSearch'.
  *
- * Function that creates a new 'Record' value and adds it to the table.
+ * - Members:
+ *      - name: name to search for.
+ *      - length: number of characters in 'name'.
+ *      - prehashValue: 'prehash' value of 'name' for the table.
+ *      - initialHash: first slot that is probed for 'name'.
+ *      - step: distance between two consecutive slots that are probed for 'name' ('hash2' value).
+ *      - result: slot that is going to be probed next, and the status of the query ('status'
+ *                is only meaningful after 'advanceProbe' returns 'true').
+ *      - index: index of the query in the batch, i.e., where to write the result.
+ */
+typedef struct probe_state {
+    const char *name;
+    int length;
+    int prehashValue;
+    int initialHash;
+    int step;
+    QueryResult result;
+    int index;
+} ProbeState;
+
+/*
+ * function: prefetchSlot
+ * ----------------------
  *
- * - Arguments:
- *      - name: name to insert.
- *      - table: hash table to insert.
- *      - slot: index to insert.
+ * Function that asks the processor to start loading given 'slot' of 'table' into the cache,
+ * without waiting for it.
  */
-void createAndInsertNewRecordToTable(const char *name, HashTable *table, int slot) {
-    Record newRecord = initRecordWithName(name);
-    table->values[slot] = newRecord;
+void prefetchSlot(const Record *table, const int slot) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(&table[slot], 0, 1);
+#else
+    (void) table; (void) slot;
+#endif
 }
 
-float currentLoadFactorOfTable(HashTable *table) {
-    return (((float) table->activeRecordCount / (float) table->length));
+/*
+ * function: startProbe
+ * --------------------
+ *
+ * Function that initializes given 'probe' for given 'name', and prefetches the first slot it is going to probe.
+ *
+ * - Arguments:
+ *      - probe: probe state to initialize.
+ *      - name: name to search for.
+ *      - length: number of characters in 'name'.
+ *      - index: index of the query in the batch.
+ *      - table: Hash table.
+ *      - M: Number of slots in table.
+ */
+void startProbe(ProbeState *probe, const char *name, const int length, const int index, const Record *table, const int M) {
+    probe->name = name;
+    probe->length = length;
+    probe->index = index;
+    probe->prehashValue = prehash(name, length, M);
+    probe->step = hash2(probe->prehashValue, M);
+    probe->initialHash = hash1(probe->prehashValue, M);
+    probe->result.slot = probe->initialHash;
+    probe->result.status = RECORD_NOT_FOUND;
+    prefetchSlot(table, probe->result.slot);
 }
 
-// MARK: User Actions
-
-void relocate(HashTable *table, int newLength, bool debugMode); // Prototype needed
-
 /*
- * function: insert
- * ----------------
+ * function: advanceProbe
+ * ----------------------
  *
- * Function that inserts a new 'Record' value with given 'name' to the table.
+ * Function that probes the current slot of given 'probe' exactly as '__search' does. If the query
+ * isn't finished yet, moves on to the next slot and prefetches it instead of waiting for it.
+ *
+ * Next slot is found by adding 'step' to the current one, as in '__search'.
  *
  * - Arguments:
- *      - name: name to insert.
- *      - table: hash table to insert.
- *      - M: number of slots in hash table.
+ *      - probe: probe state to advance.
+ *      - table: Hash table.
+ *      - M: Number of slots in table.
+ *
+ * - Returns: Whether the query is finished. If so, 'probe->result' has the same value that
+ *              '__search' would return.
  */
-void insert(const char *name, HashTable *table, bool debugMode) {
-    const QueryResult result = __search(name, table->values, table->length, INSERT, debugMode); // Search for given 'name' in hash table
-    const int slot = result.slot;
-    printf("\n");
-    switch (result.status) {
-        case RECORD_NOT_FOUND: // Empty slot found to insert given 'name'
-            createAndInsertNewRecordToTable(name, table, slot);
+bool advanceProbe(ProbeState *probe, const Record *table, const int M) {
+    const Record *record = &table[probe->result.slot];
+    if (!record->occupied) {
+        probe->result.status = RECORD_NOT_FOUND;
+        return true;
+    }
+    if (recordHasName(record, probe->name, probe->length, probe->prehashValue)) {
+        probe->result.status = (record->deleted) ? PASSIVE_RECORD_FOUND : ACTIVE_RECORD_FOUND;
+        return true;
+    }
+    probe->result.slot += probe->step;
+    if (probe->result.slot >= M) {
+        probe->result.slot -= M;
+    }
+    if (probe->result.slot == probe->initialHash) {
+        probe->result.status = RECORD_NOT_FOUND_AND_THE_TABLE_IS_FULL;
+        return true;
+    }
+    prefetchSlot(table, probe->result.slot);
+    return false;
+}
+
+/*
+ * function: __multiSearch
+ * -----------------------
+ *
+ * Batched version of '__search'. Instead of following the probe sequence of one name until the end,
+ * keeps 'PROBE_GROUP_SIZE' queries in flight and advances each of them one probe at a time, so that
+ * the cache misses of different names overlap rather than being waited for one after another.
+ * Whenever a query finishes, next name in the batch takes its place.
+ *
+ * - Arguments:
+ *      - names: Names to search for.
+ *      - lengths: Number of characters in each name.
+ *      - count: Number of names.
+ *      - table: Hash table.
+ *      - M: Number of slots in table.
+ *      - results: Array of 'count' elements, 'results[i]' is set to the value that '__search' would return for 'names[i]'.
+ *      - prehashValues: Array of 'count' elements that 'prehash' values of the names are written to, so that
+ *                       callers don't need to compute them again. Can be 'NULL'.
+ *
+ * > Warning:
+ *  Value of this function shouldn't be used directly, but rather should
+ *  be used as a part of 'multiSearch' and 'multiInsert' actions.
+ */
+void __multiSearch(const char *names[], const int lengths[], const int count, const Record *table, const int M, QueryResult results[], int prehashValues[]) {
+    ProbeState probes[PROBE_GROUP_SIZE];
+    int inFlight = 0;
+    int next = 0;
+    int i = 0;
+    while (inFlight < PROBE_GROUP_SIZE && next < count) { // Fill the group.
+        startProbe(&probes[inFlight], names[next], lengths[next], next, table, M);
+        inFlight++; next++;
+    }
+    while (inFlight > 0) {
+        for (i = 0; i < inFlight; i++) {
+            if (advanceProbe(&probes[i], table, M)) {
+                results[probes[i].index] = probes[i].result;
+                if (prehashValues != NULL) {
+                    prehashValues[probes[i].index] = probes[i].prehashValue;
+                }
+                if (next < count) { // Replace finished query with the next one.
+                    startProbe(&probes[i], names[next], lengths[next], next, table, M);
+                    next++;
+                }
+                else { // Nothing left to start, shrink the group.
+                    probes[i] = probes[--inFlight];
+                    i--;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * function: createAndInsertNewRecordToTable
+ * -----------------------------------------
+ *
+ * Function that creates a new 'Record' value and adds it to the table.
+ *
+ * - Arguments:
+ *      - name: name to insert.
+ *      - length: number of characters in 'name'.
+ *      - prehashValue: 'prehash' value of 'name' for the table.
+ *      - table: hash table to insert.
+ *      - slot: index to insert.
+ */
+void createAndInsertNewRecordToTable(const char *name, const int length, const int prehashValue, HashTable *table, int slot) {
+    Record newRecord = initRecordWithName(name, length, prehashValue);
+    table->values[slot] = newRecord;
+}
+
+float currentLoadFactorOfTable(HashTable *table) {
+    return (((float) table->activeRecordCount / (float) table->length));
+}
+
+/*
+ * function: grownLengthOfTable
+ * ----------------------------
+ *
+ * Returns the length that the table should be relocated to, when its load factor reaches the maximum.
+ * Length is doubled, and doubled again if that isn't enough to get under the maximum load factor
+ * (which may happen for very small tables). Length never exceeds 'MAX_TABLE_LENGTH'.
+ */
+int grownLengthOfTable(HashTable *table) {
+    int newLength = table->length;
+    do {
+        const long long doubledLength = 2LL * newLength;
+        newLength = firstPrimeThatFollowsGivenNumber((doubledLength < MAX_TABLE_LENGTH) ? (int) doubledLength : MAX_TABLE_LENGTH);
+    } while (newLength < MAX_TABLE_LENGTH && ((float) table->activeRecordCount / (float) newLength) >= table->loadFactor);
+    return newLength;
+}
+
+/*
+ * function: currentUsedSlotRatioOfTable
+ * -------------------------------------
+ *
+ * Returns the ratio of slots that hold a record, including the softly deleted ones. Softly deleted
+ * records still take part in probe sequences, so if this ratio isn't kept under the load factor,
+ * table can get full while its load factor is low.
+ */
+float currentUsedSlotRatioOfTable(HashTable *table) {
+    return (((float) table->usedSlotCount / (float) table->length));
+}
+
+/*
+ * function: checkTableInvariants
+ * ------------------------------
+ *
+ * Function that checks whether given 'table' is consistent, and prints a 'DEBUG' message for each
+ * violation it finds. Checks that:
+ *      - table length is prime, so that double hashing visits every slot (full-cycle probing).
+ *      - 'activeRecordCount' and 'usedSlotCount' match the records in the table.
+ *      - stored 'prehash' values match the names, for the current length of the table.
+ *      - every active record is found at its own slot by '__search' (no lost or duplicate names).
+ *      - used slot ratio is under the load factor.
+ *
+ * This function visits every slot and searches for every record, it is meant to be used by the
+ * drivers in 'fuzz/' rather than after every action.
+ *
+ * - Arguments:
+ *      - table: hash table.
+ *
+ * - Returns: Whether all the invariants hold.
+ */
+bool checkTableInvariants(HashTable *table) {
+    bool valid = true;
+    int activeRecordCount = 0;
+    int usedSlotCount = 0;
+    int i = 0;
+    if (table->length > 2 && !isPrime(table->length)) {
+        printf("DEBUG: Invariant violated: table length %d is not prime.\n", table->length);
+        valid = false;
+    }
+    for (i = 0; i < table->length; i++) {
+        const Record *record = &table->values[i];
+        if (!record->occupied) {
+            continue;
+        }
+        const char *name = recordName(record);
+        const int prehashValue = prehash(name, record->length, table->length);
+        usedSlotCount++;
+        if (record->prehashValue != prehashValue) {
+            printf("DEBUG: Invariant violated: '%.*s' at %d has prehash value %d instead of %d.\n",
+                   record->length, name, i, record->prehashValue, prehashValue);
+            valid = false;
+        }
+        if (greatestCommonDivisor(hash2(prehashValue, table->length), table->length) != 1) { // Probing wouldn't visit every slot.
+            printf("DEBUG: Invariant violated: probe step of '%.*s' at %d doesn't visit every slot.\n", record->length, name, i);
+            valid = false;
+        }
+        if (record->deleted) {
+            continue;
+        }
+        activeRecordCount++;
+        const QueryResult result = __search(name, record->length, prehashValue, table->values, table->length, SEARCH, false);
+        if (result.status != ACTIVE_RECORD_FOUND || result.slot != i) {
+            printf("DEBUG: Invariant violated: '%.*s' at %d can't be found by searching for it.\n", record->length, name, i);
+            valid = false;
+        }
+    }
+    if (activeRecordCount != table->activeRecordCount || usedSlotCount != table->usedSlotCount) {
+        printf("DEBUG: Invariant violated: table has %d active and %d used slots, but counts are %d and %d.\n",
+               activeRecordCount, usedSlotCount, table->activeRecordCount, table->usedSlotCount);
+        valid = false;
+    }
+    if (table->usedSlotCount > 0 && currentUsedSlotRatioOfTable(table) >= table->loadFactor) {
+        printf("DEBUG: Invariant violated: used slot ratio (%f) is not under the load factor (%f).\n",
+               currentUsedSlotRatioOfTable(table), table->loadFactor);
+        valid = false;
+    }
+    return valid;
+}
+
+// MARK: User Actions
+
+void relocate(HashTable *table, int newLength, bool debugMode); // Prototype needed
+void __relocate(HashTable *table, int newLength, bool printMessages, bool debugMode); // Prototype needed
+
+/*
+ * function: insert
+ * ----------------
+ *
+ * Function that inserts a new 'Record' value with given 'name' to the table.
+ *
+ * - Arguments:
+ *      - name: name to insert.
+ *      - length: number of characters in 'name'.
+ *      - table: hash table to insert.
+ *      - debugMode: whether debug messages should printed or not
+ */
+void insert(const char *name, const int length, HashTable *table, bool debugMode) {
+    if (!isValidNameLength(length)) {
+        printf("\nCouldn't insert the name, names can be at most %d characters long.\n", MAX_NAME_LENGTH);
+        return;
+    }
+    const int prehashValue = prehash(name, length, table->length);
+    const QueryResult result = __search(name, length, prehashValue, table->values, table->length, INSERT, debugMode); // Search for given 'name' in hash table
+    const int slot = result.slot;
+    printf("\n");
+    switch (result.status) {
+        case RECORD_NOT_FOUND: // Empty slot found to insert given 'name'
+            preserveSlotForSnapshots(table, slot);
+            createAndInsertNewRecordToTable(name, length, prehashValue, table, slot);
             table->activeRecordCount++;
-            printf("'%s' inserted into adress: %d.\n", name, slot);
+            table->usedSlotCount++;
+            printf("'%.*s' inserted into adress: %d.\n", length, name, slot);
             break;
         case RECORD_NOT_FOUND_AND_THE_TABLE_IS_FULL: // No empty slot in hash table
             printf("Table is full.\n");
             break;
         case PASSIVE_RECORD_FOUND: // Record in table and 'deleted' flag set to 'true'
+            preserveSlotForSnapshots(table, slot);
             table->values[slot].deleted = 0;
             table->activeRecordCount++;
-            printf("'%s' inserted into adress: %d.\n", name, slot);
+            printf("'%.*s' inserted into adress: %d.\n", length, name, slot);
             break;
         case ACTIVE_RECORD_FOUND: // 'name' is already in hash table
-            printf("Couldn't insert '%s' into table because it is already in table.\n", name);
+            printf("Couldn't insert '%.*s' into table because it is already in table.\n", length, name);
             break; // error.
     }
     if (currentLoadFactorOfTable(table) >= table->loadFactor) {
         printf("Current load factor (%f) is bigger than the maximum allowed (%f).\nRelocating records into a bigger table.\n", currentLoadFactorOfTable(table), table->loadFactor);
-        printf("New size: %d ||| old size: %d \n", firstPrimeThatFollowsGivenNumber(table->length*2) , table->length);
-        relocate(table, firstPrimeThatFollowsGivenNumber(table->length*2), debugMode);
+        const int newLength = grownLengthOfTable(table);
+        printf("New size: %d ||| old size: %d \n", newLength , table->length);
+        relocate(table, newLength, debugMode);
+    }
+    else if (currentUsedSlotRatioOfTable(table) >= table->loadFactor) {
+        printf("Too many slots (%f) are used by deleted records.\nRelocating records to remove them.\n", currentUsedSlotRatioOfTable(table));
+        relocate(table, table->length, debugMode);
     }
 }
 
@@ -568,20 +1402,26 @@ void insert(const char *name, HashTable *table, bool debugMode) {
  *
  * - Arguments:
  *      - name: name
+ *      - length: number of characters in 'name'
  *      - table: hash table
  *      - debugMode: whether debug messages should printed or not
  */
-void search(const char *name, HashTable *table, bool debugMode) {
-    const QueryResult result = __search(name, table->values, table->length, SEARCH, debugMode);
+void search(const char *name, const int length, HashTable *table, bool debugMode) {
+    if (!isValidNameLength(length)) {
+        printf("\nCouldn't search for the name, names can be at most %d characters long.\n", MAX_NAME_LENGTH);
+        return;
+    }
+    const int prehashValue = prehash(name, length, table->length);
+    const QueryResult result = __search(name, length, prehashValue, table->values, table->length, SEARCH, debugMode);
     printf("\n");
     switch (result.status) {
         case RECORD_NOT_FOUND:
         case RECORD_NOT_FOUND_AND_THE_TABLE_IS_FULL:
         case PASSIVE_RECORD_FOUND:
-            printf("Couldn't find '%s' in the table.\n", name);
+            printf("Couldn't find '%.*s' in the table.\n", length, name);
             break;
         case ACTIVE_RECORD_FOUND:
-            printf("'%s' is at the adress: %d.\n", name, result.slot);
+            printf("'%.*s' is at the adress: %d.\n", length, name, result.slot);
             break;
     }
 }
@@ -594,81 +1434,403 @@ void search(const char *name, HashTable *table, bool debugMode) {
  *
  * - Arguments:
  *      - name: name
+ *      - length: number of characters in 'name'
  *      - table: hash table
  *      - debugMode: whether debug messages should printed or not
  */
-void delete(const char *name, HashTable *table, bool debugMode) {
-    const QueryResult result = __search(name, table->values, table->length, DELETE, debugMode);
+void delete(const char *name, const int length, HashTable *table, bool debugMode) {
+    if (!isValidNameLength(length)) {
+        printf("\nCouldn't delete the name, names can be at most %d characters long.\n", MAX_NAME_LENGTH);
+        return;
+    }
+    const int prehashValue = prehash(name, length, table->length);
+    const QueryResult result = __search(name, length, prehashValue, table->values, table->length, DELETE, debugMode);
     printf("\n");
     switch (result.status) {
         case RECORD_NOT_FOUND:
         case RECORD_NOT_FOUND_AND_THE_TABLE_IS_FULL:
         case PASSIVE_RECORD_FOUND:
-            printf("Couldn't find '%s' in the table.\n", name);
+            printf("Couldn't find '%.*s' in the table.\n", length, name);
             break;
         case ACTIVE_RECORD_FOUND:
+            preserveSlotForSnapshots(table, result.slot);
             table->values[result.slot].deleted = 1;
             table->activeRecordCount--;
-            printf("Removed '%s' from adress: %d.\n", name, result.slot);
+            printf("Removed '%.*s' from adress: %d.\n", length, name, result.slot);
             if (currentLoadFactorOfTable(table) <= (table->loadFactor * 0.25)) {
-                printf("Current load factor is too low (%f).\nRelocating records into a smaller table.\n", currentLoadFactorOfTable(table));
-                relocate(table, firstPrimeThatFollowsGivenNumber(table->length/2), debugMode);
+                const int newLength = firstPrimeThatFollowsGivenNumber(table->length/2);
+                // Smaller table must still have room under the load factor. (Very small tables may not.)
+                if (((float) table->activeRecordCount / (float) newLength) < table->loadFactor) {
+                    printf("Current load factor is too low (%f).\nRelocating records into a smaller table.\n", currentLoadFactorOfTable(table));
+                    relocate(table, newLength, debugMode);
+                }
             }
             break;
     }
 }
 
 /*
- * function: relocate
- * ------------------
+ * function: multiSearch
+ * ---------------------
+ *
+ * Function that searches for many names at once. Doesn't print anything.
+ *
+ * - Arguments:
+ *      - names: names
+ *      - lengths: number of characters in each name
+ *      - count: number of names
+ *      - table: hash table
+ *      - results: array of 'count' elements, 'results[i]' is set to the result of the query for 'names[i]'.
+ *
+ * - Returns: 'false' without searching anything if a name is longer than 'MAX_NAME_LENGTH', 'true' otherwise.
+ */
+bool multiSearch(const char *names[], const int lengths[], const int count, HashTable *table, QueryResult results[]) {
+    if (!areValidNameLengths(lengths, count)) {
+        return false;
+    }
+    __multiSearch(names, lengths, count, table->values, table->length, results, NULL);
+    return true;
+}
+
+/*
+ * function: multiInsert
+ * ---------------------
+ *
+ * Function that inserts many names at once. Doesn't print anything. Result is the same
+ * as inserting the names one by one, in the given order.
+ *
+ * Names are searched in chunks with '__multiSearch', and then inserted one by one. A result
+ * is searched again with '__search' only if an earlier insert in the same chunk has taken its slot.
+ * If the table gets relocated in the middle of a chunk, rest of the chunk is searched again.
+ *
+ * - Arguments:
+ *      - names: names
+ *      - lengths: number of characters in each name
+ *      - count: number of names
+ *      - table: hash table
+ *      - results: array of 'count' elements, 'results[i]' is set to the result of the search that is done
+ *                 right before inserting 'names[i]'. ('RECORD_NOT_FOUND' and 'PASSIVE_RECORD_FOUND' mean
+ *                 that it is inserted, 'slot' may be out of date if the table is relocated later.)
+ *
+ * - Returns: 'false' without inserting anything if a name is longer than 'MAX_NAME_LENGTH', 'true' otherwise.
+ */
+bool multiInsert(const char *names[], const int lengths[], const int count, HashTable *table, QueryResult results[]) {
+    enum { CHUNK_SIZE = 8 * PROBE_GROUP_SIZE };
+    int prehashValues[CHUNK_SIZE];
+    int start = 0;
+    if (!areValidNameLengths(lengths, count)) {
+        return false;
+    }
+    while (start < count) {
+        const int chunkLength = (count - start < CHUNK_SIZE) ? (count - start) : CHUNK_SIZE;
+        int i = 0;
+        __multiSearch(&names[start], &lengths[start], chunkLength, table->values, table->length, &results[start], prehashValues);
+        for (i = start; i < start + chunkLength; i++) {
+            QueryResult *result = &results[i];
+            const int prehashValue = prehashValues[i - start];
+            if ((result->status == RECORD_NOT_FOUND && isThereAnyRecordInSlot(table->values, result->slot)) ||
+                (result->status == PASSIVE_RECORD_FOUND && isThereAnyActiveRecordInSlot(table->values, result->slot))) {
+                // Slot is taken by an earlier insert in this chunk (possibly of the same name).
+                *result = __search(names[i], lengths[i], prehashValue, table->values, table->length, INSERT, false);
+            }
+            if (result->status == RECORD_NOT_FOUND) {
+                preserveSlotForSnapshots(table, result->slot);
+                createAndInsertNewRecordToTable(names[i], lengths[i], prehashValue, table, result->slot);
+                table->activeRecordCount++;
+                table->usedSlotCount++;
+            }
+            else if (result->status == PASSIVE_RECORD_FOUND) {
+                preserveSlotForSnapshots(table, result->slot);
+                table->values[result->slot].deleted = 0;
+                table->activeRecordCount++;
+            }
+            if (currentLoadFactorOfTable(table) >= table->loadFactor) {
+                __relocate(table, grownLengthOfTable(table), false, false);
+                break; // Results of the rest of the chunk belong to the old table.
+            }
+            if (currentUsedSlotRatioOfTable(table) >= table->loadFactor) {
+                __relocate(table, table->length, false, false); // Remove the softly deleted records.
+                break;
+            }
+        }
+        start = (i < start + chunkLength) ? i+1 : start + chunkLength;
+    }
+    return true;
+}
+
+/*
+ * function: __relocate
+ * --------------------
  *
  * Function that relocates the given hash table. Rehashes all the active records
  * into a new table, but not the deleted ones.
  *
+ * > Warning:
+ *  This function shouldn't be used directly, but rather should
+ *  be used as a part of 'relocate' and batched actions.
+ *
  * - Arguments:
  *      - table: pointer to a hash table which is going to get relocated.
  *      - newLength: number of slots in the new hash table
+ *      - printMessages: whether relocated records should be printed or not
  *      - debugMode: whether debug messages should printed or not
  */
-void relocate(HashTable *table, int newLength, bool debugMode) {
+void __relocate(HashTable *table, int newLength, bool printMessages, bool debugMode) {
     Record *_records = table->values;
-    HashTable *newTable = createTable(newLength, table->loadFactor);
+    HashTable *newTable = createTable(newLength, table->loadFactor, table->allocationPolicy);
     int i = 0;
-    printf("\n");
+    if (printMessages) {
+        printf("\n");
+    }
     if (debugMode) {
         printf("DEBUG DESCRIPTION FOR RELOCATE\n");
     }
     for (i = 0; i < table->length; i++) {
         if (isThereAnyRecordInSlot(_records, i)) {
+            const char *name = recordName(&_records[i]);
+            const int length = _records[i].length;
             if (isThereAnyActiveRecordInSlot(_records, i)) {
-                QueryResult result = __search(_records[i].name, newTable->values, newLength, RELOCATE, debugMode);
-                createAndInsertNewRecordToTable(_records[i].name, newTable, result.slot);
+                const int prehashValue = prehash(name, length, newLength);
+                QueryResult result = __search(name, length, prehashValue, newTable->values, newLength, RELOCATE, debugMode);
+                newTable->values[result.slot] = _records[i]; // Move the record, heap allocated names are shared with the snapshots of old records.
+                newTable->values[result.slot].prehashValue = prehashValue;
                 newTable->activeRecordCount++;
+                name = recordName(&newTable->values[result.slot]); // Inline name moved with the record.
                 if (debugMode) {
-                    printf("DEBUG: name: '%s' -- deleted: False -- old address: %d -- New address: %d.\n",
-                           _records[i].name,
+                    printf("DEBUG: name: '%.*s' -- deleted: False -- old address: %d -- New address: %d.\n",
+                           length,
+                           name,
                            i,
                            result.slot);
                 }
-                printf("Relocating '%s' into new table. (new adress %d)\n",_records[i].name, result.slot);
+                if (printMessages) {
+                    printf("Relocating '%.*s' into new table. (new adress %d)\n", length, name, result.slot);
+                }
             }
             else {
                 if (debugMode) {
-                    printf("DEBUG: name: '%s' -- deleted: True -- old address: %d -- Won't get added to new table.\n",
-                           _records[i].name,
+                    printf("DEBUG: name: '%.*s' -- deleted: True -- old address: %d -- Won't get added to new table.\n",
+                           length,
+                           name,
                            i);
                 }
+                retireRecordName(table, &_records[i]);
             }
         }
     }
-    Record *tmp = table->values;
+    if (!freezeValuesForSnapshots(table)) { // Otherwise snapshots own the old records now.
+        releaseSlots(table->values, table->valuesMappedSize, table->allocationPolicy.debugMode);
+    }
     table->values = newTable->values;
+    table->valuesMappedSize = newTable->valuesMappedSize;
     table->activeRecordCount = newTable->activeRecordCount;
+    table->usedSlotCount = newTable->activeRecordCount; // New table has no softly deleted records.
     table->length = newTable->length;
-    free(tmp);
     free(newTable);
 }
 
+/*
+ * function: relocate
+ * ------------------
+ *
+ * Function that relocates the given hash table. Rehashes all the active records
+ * into a new table, but not the deleted ones.
+ *
+ * - Arguments:
+ *      - table: pointer to a hash table which is going to get relocated.
+ *      - newLength: number of slots in the new hash table
+ *      - debugMode: whether debug messages should printed or not
+ */
+void relocate(HashTable *table, int newLength, bool debugMode) {
+    __relocate(table, newLength, true, debugMode);
+}
+
+
+// MARK: Iterating over records
+
+/*
+ * constant: SCAN_PREFETCH_DISTANCE
+ * --------------------------------
+ * Number of slots ahead of the current one, whose heap allocated name gets prefetched during scans.
+ * Slots themselves are read sequentially, so the hardware prefetcher already keeps up with them.
+ */
+#define SCAN_PREFETCH_DISTANCE 16
+
+/*
+ * struct: RecordIterator
+ * ----------------------
+ * struct used to iterate over the active records of a hash table or a snapshot, in the order of slots.
+ *
+ * > Warning:
+ *  Iterator of a hash table is invalidated by any modification of the table. Use a snapshot to
+ *  iterate over the records while the table is being modified.
+ *
+ * - Members:
+ *      - values: records to iterate over.
+ *      - preservedChunks: chunks that are read instead of 'values' when they are not 'NULL', see 'TableSnapshot'.
+ *      - length: number of slots in 'values'.
+ *      - slot: slot of the last record returned by 'nextActiveRecord' ('-1' before the first one).
+ */
+typedef struct record_iterator {
+    const Record *values;
+    Record *const *preservedChunks;
+    int length;
+    int slot;
+} RecordIterator;
+
+/*
+ * function: createSnapshot
+ * ------------------------
+ *
+ * Function that creates a snapshot of given 'table'. Returned snapshot must be released
+ * with 'releaseSnapshot', before the table is freed.
+ *
+ * - Arguments:
+ *      - table: hash table.
+ *
+ * - Returns: Snapshot of the records in given 'table'.
+ */
+TableSnapshot *createSnapshot(HashTable *table) {
+    TableSnapshot *snapshot = malloc(sizeof(TableSnapshot));
+    const int chunkCount = (table->length + SNAPSHOT_CHUNK_LENGTH - 1) / SNAPSHOT_CHUNK_LENGTH;
+    snapshot->table = table;
+    snapshot->values = table->values;
+    snapshot->preservedChunks = calloc(chunkCount, sizeof(Record *));
+    snapshot->frozenValues = NULL;
+    snapshot->length = table->length;
+    snapshot->activeRecordCount = table->activeRecordCount;
+    snapshot->next = table->snapshots;
+    table->snapshots = snapshot;
+    table->liveSnapshotCount++;
+    return snapshot;
+}
+
+/*
+ * function: releaseSnapshot
+ * -------------------------
+ *
+ * Function that releases given 'snapshot'. Names retired by the table are freed with the last snapshot.
+ *
+ * - Arguments:
+ *      - snapshot: snapshot to release.
+ */
+void releaseSnapshot(TableSnapshot *snapshot) {
+    HashTable *table = snapshot->table;
+    const int chunkCount = (snapshot->length + SNAPSHOT_CHUNK_LENGTH - 1) / SNAPSHOT_CHUNK_LENGTH;
+    int i = 0;
+    for (i = 0; i < chunkCount; i++) {
+        free(snapshot->preservedChunks[i]);
+    }
+    free(snapshot->preservedChunks);
+    if (snapshot->frozenValues != NULL) { // Table has relocated away from the records of the snapshot.
+        snapshot->frozenValues->referenceCount--;
+        if (snapshot->frozenValues->referenceCount == 0) {
+            releaseSlots(snapshot->frozenValues->values, snapshot->frozenValues->mappedSize, table->allocationPolicy.debugMode); // Names are released by the table.
+            free(snapshot->frozenValues);
+        }
+    }
+    else {
+        TableSnapshot **link = &table->snapshots;
+        while (*link != snapshot) {
+            link = &(*link)->next;
+        }
+        *link = snapshot->next;
+    }
+    free(snapshot);
+    table->liveSnapshotCount--;
+    reclaimRetiredNames(table);
+}
+
+/*
+ * function: tableIterator
+ * -----------------------
+ *
+ * Returns an iterator over the active records of given 'table'.
+ */
+RecordIterator tableIterator(const HashTable *table) {
+    RecordIterator iterator = { table->values, NULL, table->length, -1 };
+    return iterator;
+}
+
+/*
+ * function: snapshotIterator
+ * --------------------------
+ *
+ * Returns an iterator over the active records of given 'snapshot'.
+ */
+RecordIterator snapshotIterator(const TableSnapshot *snapshot) {
+    RecordIterator iterator = { snapshot->values, snapshot->preservedChunks, snapshot->length, -1 };
+    return iterator;
+}
+
+/*
+ * function: recordAtSlotOfIterator
+ * --------------------------------
+ *
+ * Returns the record at given 'slot' that given 'iterator' reads, preserved chunk if there is one.
+ */
+const Record *recordAtSlotOfIterator(const RecordIterator *iterator, const int slot) {
+    if (iterator->preservedChunks != NULL && iterator->preservedChunks[slot / SNAPSHOT_CHUNK_LENGTH] != NULL) {
+        return &iterator->preservedChunks[slot / SNAPSHOT_CHUNK_LENGTH][slot % SNAPSHOT_CHUNK_LENGTH];
+    }
+    return &iterator->values[slot];
+}
+
+/*
+ * function: nextActiveRecord
+ * --------------------------
+ *
+ * Function that moves given 'iterator' to the next active record. Softly deleted records and
+ * empty slots are skipped. Slot of the returned record is 'iterator->slot'.
+ *
+ * - Arguments:
+ *      - iterator: iterator to advance.
+ *
+ * - Returns: Next active record, or 'NULL' if there is no more active records.
+ */
+const Record *nextActiveRecord(RecordIterator *iterator) {
+    int slot = 0;
+    for (slot = iterator->slot+1; slot < iterator->length; slot++) {
+        const int ahead = slot + SCAN_PREFETCH_DISTANCE;
+        const Record *record = recordAtSlotOfIterator(iterator, slot);
+        if (ahead < iterator->length) {
+            const Record *aheadRecord = recordAtSlotOfIterator(iterator, ahead);
+            if (aheadRecord->occupied && !isNameStoredInline(aheadRecord)) {
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(aheadRecord->storage.heapName, 0, 0);
+#endif
+            }
+        }
+        if (record->occupied && !(record->deleted)) {
+            iterator->slot = slot;
+            return record;
+        }
+    }
+    iterator->slot = iterator->length;
+    return NULL;
+}
+
+/*
+ * function: list
+ * --------------
+ *
+ * Function that prints all the active records in the table, using a snapshot of it.
+ *
+ * - Arguments:
+ *      - table: hash table
+ */
+void list(HashTable *table) {
+    TableSnapshot *snapshot = createSnapshot(table);
+    RecordIterator iterator = snapshotIterator(snapshot);
+    const Record *record = NULL;
+    printf("\n");
+    printf("%d record(s) in the table.\n", snapshot->activeRecordCount);
+    while ((record = nextActiveRecord(&iterator)) != NULL) {
+        printf("'%.*s' is at the adress: %d.\n", record->length, recordName(record), iterator.slot);
+    }
+    releaseSnapshot(snapshot);
+}
+
 
 // MARK: User Interaction (Text based UI)
 
@@ -681,29 +1843,113 @@ void relocate(HashTable *table, int newLength, bool debugMode) {
  *
  * - Arguments:
  *      - name: name
+ *      - length: number of characters in 'name'
  *      - table: hash table
  *      - action: action that is going to be performed
  *      - debugMode: whether debug messages should printed or not
  */
-void performUserAction(const char *name, HashTable *table, UserAction action, bool debugMode) {
+void performUserAction(const char *name, const int length, HashTable *table, UserAction action, bool debugMode) {
     switch (action) {
         case INSERT:
-            insert(name, table, debugMode);
+            insert(name, length, table, debugMode);
             break;
         case SEARCH:
-            search(name, table, debugMode);
+            search(name, length, table, debugMode);
             break;
         case DELETE:
-            delete(name, table, debugMode);
+            delete(name, length, table, debugMode);
             break;
         case RELOCATE:
             relocate(table, table->length, debugMode);
             break;
+        case LIST:
+            list(table);
+            break;
         default:
             break;
     }
 }
 
+/*
+ * function: performBatchUserAction
+ * --------------------------------
+ *
+ * Function that performs the desired batch action ('MULTI_INSERT' or 'MULTI_SEARCH') for
+ * all the given names at once, and prints the result for each name.
+ *
+ * - Arguments:
+ *      - names: names
+ *      - lengths: number of characters in each name
+ *      - count: number of names
+ *      - table: hash table
+ *      - action: action that is going to be performed
+ */
+void performBatchUserAction(const char *names[], const int lengths[], const int count, HashTable *table, UserAction action) {
+    QueryResult results[BATCH_CAPACITY];
+    const int oldLength = table->length;
+    int i = 0;
+    printf("\n");
+    const bool performed = (action == MULTI_INSERT) ? multiInsert(names, lengths, count, table, results)
+                                                    : multiSearch(names, lengths, count, table, results);
+    if (!performed) {
+        printf("Names can be at most %d characters long, nothing is done.\n", MAX_NAME_LENGTH);
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        switch (results[i].status) {
+            case RECORD_NOT_FOUND:
+            case PASSIVE_RECORD_FOUND:
+                if (action == MULTI_INSERT) {
+                    printf("'%.*s' inserted into table.\n", lengths[i], names[i]);
+                }
+                else {
+                    printf("Couldn't find '%.*s' in the table.\n", lengths[i], names[i]);
+                }
+                break;
+            case RECORD_NOT_FOUND_AND_THE_TABLE_IS_FULL:
+                printf("%s '%.*s', table is full.\n", (action == MULTI_INSERT) ? "Couldn't insert" : "Couldn't find", lengths[i], names[i]);
+                break;
+            case ACTIVE_RECORD_FOUND:
+                if (action == MULTI_INSERT) {
+                    printf("Couldn't insert '%.*s' into table because it is already in table.\n", lengths[i], names[i]);
+                }
+                else {
+                    printf("'%.*s' is at the adress: %d.\n", lengths[i], names[i], results[i].slot);
+                }
+                break;
+        }
+    }
+    if (table->length != oldLength) {
+        printf("Table is relocated while inserting. New size: %d ||| old size: %d \n", table->length, oldLength);
+    }
+}
+
+/*
+ * function: readNames
+ * -------------------
+ *
+ * Function that reads names from 'stdin', one name per line, until an empty line or 'BATCH_CAPACITY' names.
+ *
+ * - Arguments:
+ *      - names: buffers to read the names into.
+ *      - lengths: set to the number of characters in each name.
+ *
+ * - Returns: Number of names read.
+ */
+int readNames(char names[][BUFFER], int lengths[]) {
+    int count = 0;
+    printf("Please enter up to %d names, one per line (empty line to finish):\n", BATCH_CAPACITY);
+    while (count < BATCH_CAPACITY && fgets(names[count], BUFFER, stdin) != NULL) {
+        lengths[count] = (int) strcspn(names[count], "\n");
+        names[count][lengths[count]] = 0;
+        if (lengths[count] == 0) {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
 /*
  * function: interactWithUser
  * --------------------------
@@ -711,20 +1957,17 @@ void performUserAction(const char *name, HashTable *table, UserAction action, bo
  * Function that handles the communication between the program and the user using 'stdio'.
  *
  * - Arguments:
- *      - argc: argc
- *      - argv: argv
  *      - table: hash table
+ *      - debugMode: whether debug messages should printed or not
  */
-void interactWithUser(int argc, const char *argv[], HashTable *table) {
-    // Check whether we are in 'DEBUG' mode or not
-    bool debugMode = false;
-    if (strcmp(argv[argc-1], "DEBUG") == 0 || strcmp(argv[argc-1], "debug") == 0) {
-        debugMode = true;
-    }
-    
-    int i = 0;
+void interactWithUser(HashTable *table, bool debugMode) {
     char input[BUFFER];
     char name[BUFFER];
+    int nameLength = 0;
+    char batchNames[BATCH_CAPACITY][BUFFER];
+    const char *batchNamePointers[BATCH_CAPACITY];
+    int batchLengths[BATCH_CAPACITY];
+    int i = 0;
     
     UserAction currentUserAction = UNDEFINED;
     
@@ -733,6 +1976,9 @@ void interactWithUser(int argc, const char *argv[], HashTable *table) {
         printf("Press '%c' for deleting a record.\n", DELETE_VAL);
         printf("Press '%c' for searching a record with name.\n", SEARCH_VAL);
         printf("Press '%c' for moving records into a new table.\n", RELOCATE_VAL);
+        printf("Press '%c' for listing all records.\n", LIST_VAL);
+        printf("Press '%c' for creating several records at once.\n", MULTI_INSERT_VAL);
+        printf("Press '%c' for searching several records at once.\n", MULTI_SEARCH_VAL);
         printf("Press 'e' for exit.\n");
         printf("Action: ");
         
@@ -748,6 +1994,9 @@ void interactWithUser(int argc, const char *argv[], HashTable *table) {
             case DELETE_VAL:
             case SEARCH_VAL:
             case RELOCATE_VAL:
+            case LIST_VAL:
+            case MULTI_INSERT_VAL:
+            case MULTI_SEARCH_VAL:
                 currentUserAction = input[0]; // any of them then apply the action
                 break;
             case 'e': // 'e' is for terminating the program.
@@ -761,34 +2010,100 @@ void interactWithUser(int argc, const char *argv[], HashTable *table) {
             continue;
         }
         
-        if (currentUserAction != RELOCATE_VAL) { // If user action is not relocating, then 'name' is also required.
+        if (currentUserAction == MULTI_INSERT_VAL || currentUserAction == MULTI_SEARCH_VAL) { // Batch actions take several names.
+            const int count = readNames(batchNames, batchLengths);
+            for (i = 0; i < count; i++) {
+                batchNamePointers[i] = batchNames[i];
+            }
+            performBatchUserAction(batchNamePointers, batchLengths, count, table, currentUserAction);
+            currentUserAction = UNDEFINED;
+            printf("\n");
+            continue;
+        }
+        
+        if (currentUserAction != RELOCATE_VAL && currentUserAction != LIST_VAL) { // If user action is not relocating or listing, then 'name' is also required.
             bool validName = false;
             while (!validName) {
                 printf("Please enter a name to %s: ",
                        (currentUserAction == INSERT_VAL) ? "insert" : (currentUserAction == DELETE_VAL) ? "delete" : "search for");
                 fgets(name, BUFFER, stdin);
-                name[strcspn(name, "\n")] = 0;
-                validName = strlen(name) > 0; // careful about strlen !!? ?? ?
+                nameLength = (int) strcspn(name, "\n"); // Length is computed once here, actions don't scan 'name' again.
+                name[nameLength] = 0;
+                validName = nameLength > 0;
                 if (!validName) {
                     printf("Invalid name.\n");
                 }
             }
         }
-        performUserAction(name, table, currentUserAction, debugMode); // perform action
+        performUserAction(name, nameLength, table, currentUserAction, debugMode); // perform action
         currentUserAction = UNDEFINED; // reset variable so that the program loop continues
         printf("\n");
     }
     // Free memory used by 'table'
-    for (i = 0; i < table->length; i++) {
-        freeRecord(&(table->values[i]));
+    freeTable(table);
+}
+
+/*
+ * struct: ProgramOptions
+ * ----------------------
+ * struct used to represent the options given to the program from command line.
+ */
+typedef struct program_options {
+    bool debugMode;
+    AllocationPolicy allocationPolicy;
+} ProgramOptions;
+
+/*
+ * function: getProgramOptionsFromArguments
+ * ----------------------------------------
+ *
+ * Function that builds the 'ProgramOptions' from command line arguments. Arguments can be given in any order.
+ *
+ * Recognized arguments:
+ *      - 'DEBUG': print debug messages.
+ *      - 'HUGEPAGES': back the table with transparent huge pages.
+ *      - 'HUGETLB': back the table with reserved (explicit) huge pages.
+ *      - 'INTERLEAVE': interleave the table over all NUMA nodes.
+ *      - 'NODE=<n>': place the table on NUMA node 'n'.
+ *
+ * - Arguments:
+ *      - argc: argc
+ *      - argv: argv
+ *
+ * - Returns: 'ProgramOptions' requested by the user. (Default options if none is requested.)
+ */
+ProgramOptions getProgramOptionsFromArguments(int argc, const char *argv[]) {
+    ProgramOptions options = { false, { REGULAR_PAGES, NUMA_DEFAULT, 0, false } };
+    AllocationPolicy *policy = &options.allocationPolicy;
+    int i = 0;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "DEBUG") == 0 || strcmp(argv[i], "debug") == 0) {
+            options.debugMode = true;
+        }
+        else if (strcmp(argv[i], "HUGEPAGES") == 0 || strcmp(argv[i], "hugepages") == 0) {
+            policy->pages = TRANSPARENT_HUGE_PAGES;
+        }
+        else if (strcmp(argv[i], "HUGETLB") == 0 || strcmp(argv[i], "hugetlb") == 0) {
+            policy->pages = EXPLICIT_HUGE_PAGES;
+        }
+        else if (strcmp(argv[i], "INTERLEAVE") == 0 || strcmp(argv[i], "interleave") == 0) {
+            policy->numa = NUMA_INTERLEAVE;
+        }
+        else if (sscanf(argv[i], "NODE=%d", &policy->numaNode) == 1 || sscanf(argv[i], "node=%d", &policy->numaNode) == 1) {
+            policy->numa = NUMA_BIND;
+        }
     }
-    free(table);
+    policy->debugMode = options.debugMode;
+    return options;
 }
 
+#ifndef HASH_TABLE_NO_MAIN // Defined by the drivers in 'fuzz/', which include this file.
 int main(int argc, const char * argv[]) {
     float loadFactor = 0.0;
+    const ProgramOptions options = getProgramOptionsFromArguments(argc, argv);
     int M = getPrimeToBuildTable(&loadFactor);
-    HashTable *table = createTable(M, loadFactor);
-    interactWithUser(argc, argv, table);
+    HashTable *table = createTable(M, loadFactor, options.allocationPolicy);
+    interactWithUser(table, options.debugMode);
     return 0;
 }
+#endif
@@ -0,0 +1,520 @@
+//
+//  table_fuzz.c
+//  Hash Table
+//
+//  Differential driver for the hash table. Decodes a sequence of actions from the input bytes,
+//  applies them to a table, and compares the table with a reference set after each action.
+//  See 'Makefile' for building it as a plain program ('make check') or for libFuzzer ('make fuzz').
+//
+
+#define HASH_TABLE_NO_MAIN
+#include "../Hash Table.c"
+
+#include <stdint.h>
+#include <limits.h>
+
+/*
+ * constant: KEY_COUNT
+ * -------------------
+ * Number of names that actions pick from. Small, so that names collide with earlier actions often.
+ */
+#define KEY_COUNT 48
+
+/*
+ * constant: MAX_SNAPSHOT_COUNT
+ * ----------------------------
+ * Maximum number of snapshots that are alive at the same time.
+ */
+#define MAX_SNAPSHOT_COUNT 4
+
+/*
+ * constant: MAX_ACTION_COUNT
+ * --------------------------
+ * Maximum number of actions that are decoded from an input.
+ */
+#define MAX_ACTION_COUNT 256
+
+/*
+ * constant: INVARIANT_CHECK_LENGTH
+ * --------------------------------
+ * Tables longer than this are checked with 'checkTableInvariants' only once in a while, since it scans every slot.
+ */
+#define INVARIANT_CHECK_LENGTH 8192
+
+/*
+ * enum: FuzzAction
+ * ----------------
+ * Actions that an input byte decodes to.
+ */
+typedef enum {
+    FUZZ_INSERT,
+    FUZZ_DELETE,
+    FUZZ_SEARCH,
+    FUZZ_RELOCATE,
+    FUZZ_MULTI_INSERT,
+    FUZZ_MULTI_SEARCH,
+    FUZZ_TAKE_SNAPSHOT,
+    FUZZ_RELEASE_SNAPSHOT,
+    FUZZ_ACTION_COUNT
+} FuzzAction;
+
+/*
+ * struct: Key
+ * -----------
+ * struct used to represent a name that actions pick from. Names may contain '\0'.
+ */
+typedef struct key {
+    char name[BUFFER];
+    int length;
+} Key;
+
+/*
+ * struct: ReferenceSnapshot
+ * -------------------------
+ * struct used to represent a snapshot of the table, together with the names the table had at that time.
+ */
+typedef struct reference_snapshot {
+    TableSnapshot *snapshot;
+    bool present[KEY_COUNT];
+} ReferenceSnapshot;
+
+/*
+ * struct: FuzzInput
+ * -----------------
+ * struct used to read the input byte by byte. Reads '0' after the end of the input.
+ */
+typedef struct fuzz_input {
+    const uint8_t *data;
+    size_t size;
+    size_t position;
+} FuzzInput;
+
+static Key keys[KEY_COUNT];
+
+/*
+ * function: fail
+ * --------------
+ *
+ * Function that reports a mismatch between the table and the reference, and aborts (so that the fuzzer keeps the input).
+ * 'actionIndex' is '-1' for the checks that are done before the actions.
+ */
+static void fail(const char *message, const Key *key, const int actionIndex) {
+    fprintf(stderr, "table_fuzz: %s", message);
+    if (key != NULL) {
+        fprintf(stderr, " (key of length %d)", key->length);
+    }
+    if (actionIndex >= 0) {
+        fprintf(stderr, " after action %d", actionIndex);
+    }
+    fprintf(stderr, ".\n");
+    abort();
+}
+
+/*
+ * function: initKeys
+ * ------------------
+ *
+ * Function that fills 'keys' with short names, names around 'INLINE_NAME_CAPACITY', long (heap allocated) names,
+ * names with '\0' and non-ASCII characters, and the empty name.
+ */
+static void initKeys(void) {
+    int i = 0;
+    for (i = 0; i < KEY_COUNT; i++) {
+        Key *key = &keys[i];
+        switch (i % 6) {
+            case 0:
+                key->length = sprintf(key->name, "k%d", i);
+                break;
+            case 1:
+                key->length = sprintf(key->name, "a-name-that-does-not-fit-inline-%d", i);
+                break;
+            case 2: // '\0' in the middle of the name.
+                key->length = sprintf(key->name, "nul%dx", i);
+                key->name[1] = 0; // Digits stay, so names are still different.
+                break;
+            case 3: // Exactly 'INLINE_NAME_CAPACITY' characters, or one less or one more.
+                key->length = INLINE_NAME_CAPACITY - 1 + (i / 6) % 3;
+                memset(key->name, 'a' + (i / 6), key->length);
+                break;
+            case 4:
+                key->length = sprintf(key->name, "\xff\xfe%d", i);
+                break;
+            case 5:
+                key->length = (i == 5) ? 0 : sprintf(key->name, "%d", i * 7919);
+                break;
+        }
+    }
+}
+
+/*
+ * function: nextByte
+ * ------------------
+ *
+ * Returns the next byte of given 'input', '0' if it has ended.
+ */
+static uint8_t nextByte(FuzzInput *input) {
+    return (input->position < input->size) ? input->data[input->position++] : 0;
+}
+
+/*
+ * function: hasEnded
+ * ------------------
+ *
+ * Returns whether all the bytes of given 'input' are read.
+ */
+static bool hasEnded(const FuzzInput *input) {
+    return input->position >= input->size;
+}
+
+/*
+ * function: keyIndexOfRecord
+ * --------------------------
+ *
+ * Returns the index of the key that has the name of given 'record', '-1' if there is no such key.
+ */
+static int keyIndexOfRecord(const Record *record) {
+    int i = 0;
+    for (i = 0; i < KEY_COUNT; i++) {
+        if (keys[i].length == (int) record->length && memcmp(keys[i].name, recordName(record), record->length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * function: verifyTable
+ * ---------------------
+ *
+ * Function that compares given 'table' with the reference set 'present'.
+ */
+static void verifyTable(HashTable *table, const bool present[], const int actionIndex, const bool checkInvariants) {
+    int activeRecordCount = 0;
+    int i = 0;
+    if (checkInvariants && !checkTableInvariants(table)) {
+        fail("table invariants are violated", NULL, actionIndex);
+    }
+    for (i = 0; i < KEY_COUNT; i++) {
+        const int prehashValue = prehash(keys[i].name, keys[i].length, table->length);
+        const QueryResult result = __search(keys[i].name, keys[i].length, prehashValue, table->values, table->length, SEARCH, false);
+        if ((result.status == ACTIVE_RECORD_FOUND) != present[i]) {
+            fail(present[i] ? "inserted name is not found" : "deleted name is found", &keys[i], actionIndex);
+        }
+        activeRecordCount += present[i];
+    }
+    if (activeRecordCount != table->activeRecordCount) {
+        fail("active record count differs from the reference", NULL, actionIndex);
+    }
+}
+
+/*
+ * function: verifySnapshot
+ * ------------------------
+ *
+ * Function that compares the records of given snapshot with the names the table had when it was taken.
+ */
+static void verifySnapshot(const ReferenceSnapshot *reference, const int actionIndex) {
+    RecordIterator iterator = snapshotIterator(reference->snapshot);
+    const Record *record = NULL;
+    bool seen[KEY_COUNT] = { false };
+    int expectedCount = 0;
+    int count = 0;
+    int i = 0;
+    while ((record = nextActiveRecord(&iterator)) != NULL) {
+        const int keyIndex = keyIndexOfRecord(record);
+        if (keyIndex < 0 || !reference->present[keyIndex] || seen[keyIndex]) {
+            fail("snapshot has a record that the table didn't have", NULL, actionIndex);
+        }
+        seen[keyIndex] = true;
+        count++;
+    }
+    for (i = 0; i < KEY_COUNT; i++) {
+        expectedCount += reference->present[i];
+    }
+    if (count != expectedCount || count != reference->snapshot->activeRecordCount) {
+        fail("snapshot has lost records", NULL, actionIndex);
+    }
+}
+
+/*
+ * function: verifyLargeTableHashing
+ * ---------------------------------
+ *
+ * Function that checks hashing for table lengths that are too big to allocate in the driver, where
+ * intermediate values of 'prehash' and table growth don't fit in 'int'. 'prehash' is compared with
+ * a computation in unsigned 64 bits, and probe values must be valid slots.
+ */
+static void verifyLargeTableHashing(void) {
+    static const int lengths[] = { 100000007, MAX_TABLE_LENGTH };
+    static const Key extraKey = { "user-13@example.com", 19 };
+    HashTable table;
+    int i = 0;
+    int j = 0;
+    for (i = 0; i < (int) (sizeof(lengths) / sizeof(lengths[0])); i++) {
+        const int M = lengths[i];
+        for (j = 0; j <= KEY_COUNT; j++) {
+            const Key *key = (j < KEY_COUNT) ? &keys[j] : &extraKey;
+            const int prehashValue = prehash(key->name, key->length, M);
+            unsigned long long expected = 0;
+            int k = 0;
+            for (k = key->length-1; k >= 0; k--) {
+                expected = (31 * expected + (unsigned char) key->name[k]) % (unsigned long long) M;
+            }
+            if (prehashValue != (int) expected || hash1(prehashValue, M) < 0 ||
+                hash2(prehashValue, M) < 1 || hash2(prehashValue, M) >= M) {
+                fail("prehash of a large table is out of range", key, -1);
+            }
+        }
+    }
+    memset(&table, 0, sizeof(table));
+    table.loadFactor = 0.5f;
+    table.length = MAX_TABLE_LENGTH / 2 + 1;
+    table.activeRecordCount = table.length / 2;
+    if (grownLengthOfTable(&table) != MAX_TABLE_LENGTH) {
+        fail("grown length of a large table exceeds the maximum", NULL, -1);
+    }
+}
+
+/*
+ * function: verifyNameLengthLimits
+ * --------------------------------
+ *
+ * Function that checks that names longer than 'MAX_NAME_LENGTH' (or with negative length) are rejected
+ * by every action, before any of their characters is read.
+ */
+static void verifyNameLengthLimits(HashTable *table, const bool present[]) {
+    static const int invalidLengths[] = { MAX_NAME_LENGTH + 1, INT_MAX, -1 };
+    const char *names[2] = { keys[0].name, keys[0].name };
+    QueryResult results[2];
+    int lengths[2] = { keys[0].length, 0 };
+    int i = 0;
+    for (i = 0; i < (int) (sizeof(invalidLengths) / sizeof(invalidLengths[0])); i++) {
+        insert(keys[0].name, invalidLengths[i], table, false);
+        search(keys[0].name, invalidLengths[i], table, false);
+        delete(keys[0].name, invalidLengths[i], table, false);
+        lengths[1] = invalidLengths[i];
+        if (multiInsert(names, lengths, 2, table, results) || multiSearch(names, lengths, 2, table, results)) {
+            fail("batch with an invalid name length is accepted", NULL, -1);
+        }
+    }
+    verifyTable(table, present, -1, true);
+}
+
+/*
+ * function: runActions
+ * --------------------
+ *
+ * Function that decodes the table configuration and actions from given 'input', and applies them.
+ *
+ * First byte selects the allocation policy and whether the table is big enough to be mapped with 'mmap'.
+ * Second byte selects the load factor and the initial length. Rest is a sequence of actions, each is
+ * a byte that selects the 'FuzzAction', followed by the bytes of its operands.
+ */
+static void runActions(FuzzInput *input) {
+    static const float loadFactors[] = { 0.3f, 0.5f, 0.75f, 0.9f };
+    const uint8_t configuration = nextByte(input);
+    const uint8_t sizing = nextByte(input);
+    const bool big = (configuration / 9) % 2;
+    const AllocationPolicy policy = { (PageKind) (configuration % 3), (NumaPlacement) ((configuration / 3) % 3), 0, false };
+    const float loadFactor = loadFactors[sizing % 4];
+    const int M = big ? firstPrimeThatFollowsGivenNumber(HUGE_PAGE_SIZE / sizeof(Record) + 1) : firstPrimeThatFollowsGivenNumber(2 + sizing / 4 % 16);
+    HashTable *table = createTable(M, loadFactor, policy);
+    ReferenceSnapshot snapshots[MAX_SNAPSHOT_COUNT];
+    int snapshotCount = 0;
+    bool present[KEY_COUNT] = { false };
+    const char *names[BATCH_CAPACITY];
+    int lengths[BATCH_CAPACITY];
+    int keyIndices[BATCH_CAPACITY];
+    QueryResult results[BATCH_CAPACITY];
+    int actionIndex = 0;
+    int i = 0;
+
+    verifyNameLengthLimits(table, present);
+
+    for (actionIndex = 0; actionIndex < MAX_ACTION_COUNT && !hasEnded(input); actionIndex++) {
+        const FuzzAction action = (FuzzAction) (nextByte(input) % FUZZ_ACTION_COUNT);
+        switch (action) {
+            case FUZZ_INSERT: {
+                const Key *key = &keys[nextByte(input) % KEY_COUNT];
+                insert(key->name, key->length, table, false);
+                present[key - keys] = true;
+                break;
+            }
+            case FUZZ_DELETE: {
+                const Key *key = &keys[nextByte(input) % KEY_COUNT];
+                delete(key->name, key->length, table, false);
+                present[key - keys] = false;
+                break;
+            }
+            case FUZZ_SEARCH: {
+                const Key *key = &keys[nextByte(input) % KEY_COUNT];
+                search(key->name, key->length, table, false);
+                break;
+            }
+            case FUZZ_RELOCATE:
+                relocate(table, (nextByte(input) % 2) ? grownLengthOfTable(table) : table->length, false);
+                break;
+            case FUZZ_MULTI_INSERT:
+            case FUZZ_MULTI_SEARCH: {
+                const int count = nextByte(input) % BATCH_CAPACITY + 1;
+                for (i = 0; i < count; i++) {
+                    keyIndices[i] = nextByte(input) % KEY_COUNT;
+                    names[i] = keys[keyIndices[i]].name;
+                    lengths[i] = keys[keyIndices[i]].length;
+                }
+                if (action == FUZZ_MULTI_INSERT) {
+                    multiInsert(names, lengths, count, table, results);
+                    for (i = 0; i < count; i++) {
+                        const bool inserted = results[i].status == RECORD_NOT_FOUND || results[i].status == PASSIVE_RECORD_FOUND;
+                        if (inserted == present[keyIndices[i]]) {
+                            fail("multiInsert result differs from the reference", &keys[keyIndices[i]], actionIndex);
+                        }
+                        present[keyIndices[i]] = true;
+                    }
+                }
+                else {
+                    multiSearch(names, lengths, count, table, results);
+                    for (i = 0; i < count; i++) {
+                        if ((results[i].status == ACTIVE_RECORD_FOUND) != present[keyIndices[i]] ||
+                            (results[i].status == ACTIVE_RECORD_FOUND && keyIndexOfRecord(&table->values[results[i].slot]) != keyIndices[i])) {
+                            fail("multiSearch result differs from the reference", &keys[keyIndices[i]], actionIndex);
+                        }
+                    }
+                }
+                break;
+            }
+            case FUZZ_TAKE_SNAPSHOT:
+                if (snapshotCount < MAX_SNAPSHOT_COUNT) {
+                    snapshots[snapshotCount].snapshot = createSnapshot(table);
+                    memcpy(snapshots[snapshotCount].present, present, sizeof(present));
+                    snapshotCount++;
+                }
+                break;
+            case FUZZ_RELEASE_SNAPSHOT:
+                if (snapshotCount > 0) {
+                    const int index = nextByte(input) % snapshotCount;
+                    verifySnapshot(&snapshots[index], actionIndex);
+                    releaseSnapshot(snapshots[index].snapshot);
+                    snapshots[index] = snapshots[--snapshotCount];
+                }
+                break;
+            case FUZZ_ACTION_COUNT:
+                break;
+        }
+        verifyTable(table, present, actionIndex, table->length < INVARIANT_CHECK_LENGTH || actionIndex % 64 == 0);
+        for (i = 0; i < snapshotCount; i++) {
+            verifySnapshot(&snapshots[i], actionIndex);
+        }
+    }
+    verifyTable(table, present, actionIndex, true);
+    while (snapshotCount > 0) {
+        verifySnapshot(&snapshots[snapshotCount-1], actionIndex);
+        releaseSnapshot(snapshots[--snapshotCount].snapshot);
+    }
+    freeTable(table);
+}
+
+/*
+ * function: LLVMFuzzerTestOneInput
+ * --------------------------------
+ *
+ * Entry point for libFuzzer (and other fuzzers that use the same interface).
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static bool initialized = false;
+    FuzzInput input = { data, size, 0 };
+    if (!initialized) {
+        initKeys();
+        verifyLargeTableHashing();
+        freopen("/dev/null", "w", stdout); // Table prints every action, mismatches are reported on 'stderr'.
+        initialized = true;
+    }
+    runActions(&input);
+    return 0;
+}
+
+#ifndef LIBFUZZER
+
+/*
+ * constant: RANDOM_INPUT_COUNT
+ * ----------------------------
+ * Number of random inputs that are run when no input file is given.
+ */
+#define RANDOM_INPUT_COUNT 4000
+
+/*
+ * function: runFile
+ * -----------------
+ *
+ * Function that runs the input in the file at given 'path' ('-' for 'stdin', e.g. for AFL).
+ */
+static void runFile(const char *path) {
+    static uint8_t data[1 << 16];
+    FILE *file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    size_t size = 0;
+    if (file == NULL) {
+        fprintf(stderr, "table_fuzz: couldn't open '%s'.\n", path);
+        exit(1);
+    }
+    size = fread(data, 1, sizeof(data), file);
+    if (file != stdin) {
+        fclose(file);
+    }
+    LLVMFuzzerTestOneInput(data, size);
+}
+
+/*
+ * function: runRandomInputs
+ * -------------------------
+ *
+ * Function that runs 'RANDOM_INPUT_COUNT' pseudo random inputs, generated from given 'seed'.
+ * Big tables are scanned slowly by the invariant checks, so only one of eight inputs uses them.
+ */
+static void runRandomInputs(uint64_t seed) {
+    static uint8_t data[2 + 3 * MAX_ACTION_COUNT];
+    int i = 0;
+    size_t j = 0;
+    for (i = 0; i < RANDOM_INPUT_COUNT; i++) {
+        const size_t size = 2 + (seed % (sizeof(data) - 2));
+        for (j = 0; j < size; j++) {
+            seed ^= seed << 13; // xorshift64
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            data[j] = (uint8_t) (seed >> 24);
+        }
+        if ((data[0] / 9) % 2 && (seed >> 40) % 8 != 0) {
+            data[0] -= 9; // Same policy, small table.
+        }
+        LLVMFuzzerTestOneInput(data, size);
+    }
+    fprintf(stderr, "table_fuzz: %d random inputs matched the reference.\n", RANDOM_INPUT_COUNT);
+}
+
+/*
+ * function: main
+ * --------------
+ *
+ * Runs the input files given as arguments, or random inputs if there is none.
+ * 'SEED=<n>' changes the seed of the random inputs.
+ */
+int main(int argc, const char *argv[]) {
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    bool ranFile = false;
+    int i = 0;
+    for (i = 1; i < argc; i++) {
+        unsigned long long value = 0;
+        if (sscanf(argv[i], "SEED=%llu", &value) == 1) {
+            seed = (value != 0) ? value : seed;
+        }
+        else {
+            runFile(argv[i]);
+            ranFile = true;
+        }
+    }
+    if (!ranFile) {
+        runRandomInputs(seed);
+    }
+    return 0;
+}
+
+#endif